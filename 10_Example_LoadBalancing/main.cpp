@@ -0,0 +1,187 @@
+// Irregular workloads for comparing TBB partitioners.
+//
+// The other parallel_for examples do the same work for every index, so any
+// partitioner looks fine. Here the cost per index is uneven:
+//
+//   mandelbrot  - one image row per index, rows crossing the set are expensive
+//   triangular  - for i: for j < i, cost grows linearly with the index
+//   heavy-tail  - per-element cost drawn from a Pareto distribution (alpha 1.2):
+//                 most elements are cheap, a few take thousands of times longer
+//
+// Each kernel runs with every partitioner. Every worker records the time it
+// spends inside the loop body (thread index from this_task_arena), which gives
+//
+//   makespan    - wall time of the parallel_for
+//   ideal       - total busy time / workers (perfect balance, no overhead)
+//   efficiency  - ideal / makespan
+//   max/mean    - busiest worker against the average worker
+//
+// g++ -O3 -march=native -std=c++17 main.cpp -pthread -ltbb
+// ./a.out [threads]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+#include <cmath>
+
+#include <tbb/tbb.h>
+#include "oneapi/tbb/blocked_range.h"
+#include "oneapi/tbb/parallel_for.h"
+#include "oneapi/tbb/partitioner.h"
+#include "oneapi/tbb/task_arena.h"
+#include "oneapi/tbb/global_control.h"
+
+using namespace std;
+using namespace oneapi;
+
+// ---------------------------------------------------------------------------
+// Kernels: work(i) does the work of index i and stores its result
+// ---------------------------------------------------------------------------
+
+struct Mandelbrot {
+    int width = 800, height = 600, max_iter = 1000;
+    vector<int> image = vector<int>(width * height);
+
+    const char* name() const { return "mandelbrot"; }
+    int size() const { return height; }
+    void work(int row) {
+        double ci = -1.2 + 2.4 * row / height;
+        for (int col = 0; col < width; col++) {
+            double cr = -2.2 + 3.2 * col / width;
+            double zr = 0, zi = 0;
+            int it = 0;
+            while (it < max_iter && zr * zr + zi * zi < 4.0) {
+                double t = zr * zr - zi * zi + cr;
+                zi = 2.0 * zr * zi + ci;
+                zr = t;
+                it++;
+            }
+            image[row * width + col] = it;
+        }
+    }
+};
+
+struct Triangular {
+    int n = 6000;
+    vector<double> out = vector<double>(n);
+
+    const char* name() const { return "triangular"; }
+    int size() const { return n; }
+    void work(int i) {
+        double acc = 0;
+        for (int j = 0; j < i; j++)
+            acc += sqrt((double)i * j + 1.0);
+        out[i] = acc;
+    }
+};
+
+struct HeavyTail {
+    int n = 200000;
+    vector<int> cost = vector<int>(n);
+    vector<double> out = vector<double>(n);
+
+    HeavyTail() {
+        mt19937 gen(5);
+        uniform_real_distribution<double> u(0.0, 1.0);
+        for (auto& c : cost)
+            c = (int)min(1e5, 10.0 / pow(1.0 - u(gen), 1.0 / 1.2));
+    }
+    const char* name() const { return "heavy-tail"; }
+    int size() const { return n; }
+    void work(int i) {
+        double x = i;
+        for (int k = 0; k < cost[i]; k++)
+            x = x * 0.999999 + 1.0;
+        out[i] = x;
+    }
+};
+
+// ---------------------------------------------------------------------------
+
+struct Result {
+    double makespan;
+    vector<double> busy;
+    vector<long> chunks;
+};
+
+template <class Kernel, class Partitioner>
+Result Run(Kernel& k, int threads, size_t grain, Partitioner& part)
+{
+    Result res;
+    res.busy.assign(threads, 0.0);
+    res.chunks.assign(threads, 0);
+    tbb::task_arena arena(threads);
+    arena.execute([&] {
+        tbb::tick_count t0 = tbb::tick_count::now();
+        tbb::parallel_for(
+            tbb::blocked_range<int>(0, k.size(), grain),
+            [&](tbb::blocked_range<int> r) {
+                tbb::tick_count b0 = tbb::tick_count::now();
+                for (int i = r.begin(); i < r.end(); i++)
+                    k.work(i);
+                int w = tbb::this_task_arena::current_thread_index();
+                res.busy[w] += (tbb::tick_count::now() - b0).seconds();
+                res.chunks[w]++;
+            },
+            part
+        );
+        res.makespan = (tbb::tick_count::now() - t0).seconds();
+    });
+    return res;
+}
+
+void Report(const string& part, const Result& r)
+{
+    int p = r.busy.size();
+    double total = accumulate(r.busy.begin(), r.busy.end(), 0.0);
+    double ideal = total / p;
+    double mx = *max_element(r.busy.begin(), r.busy.end());
+    long chunks = accumulate(r.chunks.begin(), r.chunks.end(), 0L);
+    cout << "  " << left << setw(18) << part << right << fixed
+         << setprecision(2) << setw(10) << r.makespan * 1e3 << setw(10) << ideal * 1e3
+         << setw(8) << setprecision(1) << 100.0 * ideal / r.makespan << "%"
+         << setw(9) << setprecision(2) << (ideal > 0 ? mx / ideal : 0.0)
+         << setw(9) << chunks << "   busy ms:";
+    for (double b : r.busy)
+        cout << ' ' << setprecision(1) << b * 1e3;
+    cout << endl;
+}
+
+template <class Kernel>
+void Evaluate(Kernel k, int threads)
+{
+    cout << k.name() << " (" << k.size() << " indices, " << threads << " workers)" << endl;
+    cout << "  " << left << setw(18) << "partitioner" << right << setw(10) << "makespan"
+         << setw(10) << "ideal" << setw(9) << "eff" << setw(9) << "max/mean"
+         << setw(9) << "chunks" << endl;
+
+    tbb::auto_partitioner ap;
+    Report("auto", Run(k, threads, 1, ap));
+    tbb::simple_partitioner sp;
+    Report("simple, grain 1", Run(k, threads, 1, sp));
+    size_t coarse = max(1, k.size() / (4 * threads));
+    Report("simple, grain n/4P", Run(k, threads, coarse, sp));
+    tbb::static_partitioner stp;
+    Report("static", Run(k, threads, 1, stp));
+    tbb::affinity_partitioner afp;
+    Run(k, threads, 1, afp); // first run records the affinity
+    Report("affinity (2nd run)", Run(k, threads, 1, afp));
+    cout << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    int threads = argc > 1 ? atoi(argv[1]) : tbb::info::default_concurrency();
+    cout << "Default concurrency " << tbb::info::default_concurrency() << endl << endl;
+    // allow more workers than cores when asked for, e.g. to see imbalance on a laptop
+    tbb::global_control allow(tbb::global_control::max_allowed_parallelism, threads);
+
+    Evaluate(Mandelbrot(), threads);
+    Evaluate(Triangular(), threads);
+    Evaluate(HeavyTail(), threads);
+    return 0;
+}
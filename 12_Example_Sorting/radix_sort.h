@@ -0,0 +1,239 @@
+// Parallel LSD radix sort, built from the same three steps as the filter of
+// 6_Example_PackingProblem: per-block counts, a prefix over the counts and a
+// scatter to the computed positions. Here the counts are a histogram of the
+// current digit per block, so every block knows where each of its elements
+// goes and the scatter is stable.
+//
+//     RadixSort(&keys[0], n);                    // uint32/64, int32/64, float, double
+//     RadixSort(&keys[0], &values[0], n);        // key-value pairs, sorted by key
+//     RadixSort(&keys[0], n, 11);                // 11-bit digits instead of 8
+//
+// Keys are mapped to unsigned integers with the same order (sign bit flipped
+// for signed integers, IEEE floats flipped on their sign) while the digits are
+// extracted, the stored keys are never modified. -0.0 sorts before +0.0, NaNs
+// with the sign bit clear after +inf.
+//
+// Two details matter for speed:
+//
+//   skipped passes  one parallel sweep computes the histograms of all digits;
+//                   a digit on which all keys agree (e.g. the high bytes of
+//                   small 64-bit keys) is not sorted on
+//   write combining a scatter to 256 or 2048 destinations touches a new page
+//                   and cache line on almost every store. Every block first
+//                   collects 64 bytes per destination in a small buffer and
+//                   copies full lines out, so each store stream stays in the
+//                   cache and the TLB. Pass combine = false to compare.
+//
+// Extra memory: one n-element buffer for the keys (and one for the values),
+// plus blocks x 2^bits counters.
+
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include <oneapi/tbb/blocked_range.h>
+#include <oneapi/tbb/parallel_for.h>
+#include <oneapi/tbb/enumerable_thread_specific.h>
+
+namespace radix {
+
+// order-preserving map to an unsigned integer of the same size
+template <class Key, class Enable = void>
+struct KeyBits;
+
+template <class Key>
+struct KeyBits<Key, typename std::enable_if<std::is_integral<Key>::value>::type> {
+    typedef typename std::make_unsigned<Key>::type type;
+    static type get(Key k) {
+        type u = (type)k;
+        if (std::is_signed<Key>::value)
+            u ^= (type)1 << (8 * sizeof(Key) - 1);
+        return u;
+    }
+};
+
+template <class Key>
+struct KeyBits<Key, typename std::enable_if<std::is_floating_point<Key>::value>::type> {
+    typedef typename std::conditional<sizeof(Key) == 4, uint32_t, uint64_t>::type type;
+    static type get(Key k) {
+        type u;
+        std::memcpy(&u, &k, sizeof(Key));
+        const type sign = (type)1 << (8 * sizeof(Key) - 1);
+        return (u & sign) ? ~u : (u | sign);
+    }
+};
+
+struct NoValue {};
+
+const std::size_t kBlock = 1 << 16;   // elements per block
+
+namespace detail {
+
+// write-combining buffer of one thread: 64 bytes of keys per destination bucket
+template <class Key, class Value>
+struct Combine {
+    static const int kKeys = 64 / sizeof(Key);
+    std::vector<Key> keys;
+    std::vector<Value> values;
+    std::vector<unsigned char> fill;
+
+    void resize(std::size_t buckets) {
+        keys.resize(buckets * kKeys);
+        if (!std::is_same<Value, NoValue>::value)
+            values.resize(buckets * kKeys);
+        fill.assign(buckets, 0);
+    }
+};
+
+template <class Key, class Value>
+void Sort(Key* keys, Value* values, std::size_t n, int bits, bool combine)
+{
+    typedef typename KeyBits<Key>::type U;
+    const bool has_values = !std::is_same<Value, NoValue>::value;
+    const int key_bits = 8 * sizeof(Key);
+    const int passes = (key_bits + bits - 1) / bits;
+    const std::size_t buckets = std::size_t(1) << bits;
+    const U mask = (U)(buckets - 1);
+    const std::size_t blocks = (n + kBlock - 1) / kBlock;
+    if (n < 2)
+        return;
+
+    // histograms of every digit, to find the passes that can be skipped
+    std::vector<std::size_t> digit_count(passes * buckets, 0);
+    {
+        oneapi::tbb::enumerable_thread_specific<std::vector<std::size_t>> local(
+            [&] { return std::vector<std::size_t>(passes * buckets, 0); });
+        oneapi::tbb::parallel_for(
+            oneapi::tbb::blocked_range<std::size_t>(0, n, kBlock),
+            [&](const oneapi::tbb::blocked_range<std::size_t>& r) {
+                std::vector<std::size_t>& h = local.local();
+                for (std::size_t i = r.begin(); i != r.end(); ++i) {
+                    U u = KeyBits<Key>::get(keys[i]);
+                    for (int p = 0; p < passes; p++)
+                        h[p * buckets + ((u >> (p * bits)) & mask)]++;
+                }
+            });
+        for (const std::vector<std::size_t>& h : local)
+            for (std::size_t b = 0; b < h.size(); b++)
+                digit_count[b] += h[b];
+    }
+
+    std::vector<Key> key_tmp(n);
+    std::vector<Value> value_tmp(has_values ? n : 0);
+    Key* src_k = keys;
+    Key* dst_k = &key_tmp[0];
+    Value* src_v = values;
+    Value* dst_v = has_values ? &value_tmp[0] : nullptr;
+
+    // count[block * buckets + digit], turned into output positions in place
+    std::vector<std::size_t> count(blocks * buckets);
+    oneapi::tbb::enumerable_thread_specific<Combine<Key, Value>> wc;
+
+    for (int p = 0; p < passes; p++) {
+        const int shift = p * bits;
+        const std::size_t* total = &digit_count[p * buckets];
+        if (*std::max_element(total, total + buckets) == n)
+            continue;
+
+        oneapi::tbb::parallel_for(
+            oneapi::tbb::blocked_range<std::size_t>(0, blocks, 1),
+            [&](const oneapi::tbb::blocked_range<std::size_t>& r) {
+                for (std::size_t b = r.begin(); b != r.end(); ++b) {
+                    std::size_t* c = &count[b * buckets];
+                    std::fill(c, c + buckets, 0);
+                    for (std::size_t i = b * kBlock; i < std::min(n, (b + 1) * kBlock); ++i)
+                        c[(KeyBits<Key>::get(src_k[i]) >> shift) & mask]++;
+                }
+            });
+
+        // position of (block, digit) = all smaller digits + same digit in earlier blocks
+        std::size_t pos = 0;
+        for (std::size_t d = 0; d < buckets; d++)
+            for (std::size_t b = 0; b < blocks; b++) {
+                std::size_t c = count[b * buckets + d];
+                count[b * buckets + d] = pos;
+                pos += c;
+            }
+
+        oneapi::tbb::parallel_for(
+            oneapi::tbb::blocked_range<std::size_t>(0, blocks, 1),
+            [&](const oneapi::tbb::blocked_range<std::size_t>& r) {
+                Combine<Key, Value>& buf = wc.local();
+                if (combine && buf.fill.size() != buckets)
+                    buf.resize(buckets);
+                const int L = Combine<Key, Value>::kKeys;
+                for (std::size_t b = r.begin(); b != r.end(); ++b) {
+                    std::size_t* out = &count[b * buckets];
+                    std::size_t lo = b * kBlock, hi = std::min(n, lo + kBlock);
+                    if (!combine) {
+                        for (std::size_t i = lo; i < hi; ++i) {
+                            std::size_t d = (KeyBits<Key>::get(src_k[i]) >> shift) & mask;
+                            std::size_t o = out[d]++;
+                            dst_k[o] = src_k[i];
+                            if constexpr (!std::is_same<Value, NoValue>::value)
+                                dst_v[o] = src_v[i];
+                        }
+                        continue;
+                    }
+                    for (std::size_t i = lo; i < hi; ++i) {
+                        std::size_t d = (KeyBits<Key>::get(src_k[i]) >> shift) & mask;
+                        int f = buf.fill[d];
+                        buf.keys[d * L + f] = src_k[i];
+                        if constexpr (!std::is_same<Value, NoValue>::value)
+                            buf.values[d * L + f] = src_v[i];
+                        if (++f == L) {
+                            std::memcpy(dst_k + out[d], &buf.keys[d * L], L * sizeof(Key));
+                            if constexpr (!std::is_same<Value, NoValue>::value)
+                                std::copy(&buf.values[d * L], &buf.values[d * L] + L, dst_v + out[d]);
+                            out[d] += L;
+                            f = 0;
+                        }
+                        buf.fill[d] = f;
+                    }
+                    for (std::size_t d = 0; d < buckets; d++) {
+                        int f = buf.fill[d];
+                        std::memcpy(dst_k + out[d], &buf.keys[d * L], f * sizeof(Key));
+                        if constexpr (!std::is_same<Value, NoValue>::value)
+                            std::copy(&buf.values[d * L], &buf.values[d * L] + f, dst_v + out[d]);
+                        out[d] += f;
+                        buf.fill[d] = 0;
+                    }
+                }
+            });
+        std::swap(src_k, dst_k);
+        std::swap(src_v, dst_v);
+    }
+
+    if (src_k != keys) {
+        oneapi::tbb::parallel_for(
+            oneapi::tbb::blocked_range<std::size_t>(0, n, kBlock),
+            [&](const oneapi::tbb::blocked_range<std::size_t>& r) {
+                std::copy(src_k + r.begin(), src_k + r.end(), keys + r.begin());
+                if constexpr (!std::is_same<Value, NoValue>::value)
+                    std::copy(src_v + r.begin(), src_v + r.end(), values + r.begin());
+            });
+    }
+}
+
+} // namespace detail
+
+template <class Key>
+void RadixSort(Key* keys, std::size_t n, int bits = 8, bool combine = true)
+{
+    detail::Sort<Key, NoValue>(keys, nullptr, n, bits, combine);
+}
+
+template <class Key, class Value>
+void RadixSort(Key* keys, Value* values, std::size_t n, int bits = 8, bool combine = true)
+{
+    detail::Sort<Key, Value>(keys, values, n, bits, combine);
+}
+
+} // namespace radix
+
+#endif
@@ -0,0 +1,199 @@
+// Parallel sample sort (super scalar sample sort, Sanders & Winkel) for any
+// random-access range and any strict weak ordering:
+//
+//     SampleSort(v.begin(), v.end());
+//     SampleSort(v.begin(), v.end(), [](const Rec& a, const Rec& b) { return a.key < b.key; });
+//
+// One level splits the range into up to 2k - 1 buckets with the partition
+// steps of 6_Example_PackingProblem, generalised from 2 to k outputs:
+//
+//   splitters  k * oversample random elements are sorted and every
+//              oversample-th one becomes a splitter, so the buckets come out
+//              close to n / k elements even for skewed inputs
+//   classify   the k - 1 splitters are stored as an implicit binary search
+//              tree; log2(k) steps of j = 2j + (splitter[j] < x) find the
+//              bucket without a branch. The bucket of every element is kept
+//              in an oracle array, counts go into a chunks x buckets matrix
+//   prefix     one pass over the matrix in bucket-major order gives every
+//              (chunk, bucket) pair its output position
+//   scatter    every chunk moves its elements to a buffer at those positions
+//              and the buffer is moved back
+//   recurse    every bucket is sorted in a task_group: big ones by another
+//              level, small ones by std::sort
+//
+// Elements equal to a splitter get a bucket of their own, which needs no
+// further sorting, so inputs with many duplicates do not recurse on a bucket
+// that never gets smaller.
+//
+// Input that is already sorted is detected by one parallel pass and left alone.
+//
+// Extra memory: n elements plus n bytes of oracle.
+
+#ifndef SAMPLE_SORT_H
+#define SAMPLE_SORT_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include <oneapi/tbb/blocked_range.h>
+#include <oneapi/tbb/parallel_for.h>
+#include <oneapi/tbb/parallel_reduce.h>
+#include <oneapi/tbb/task_group.h>
+
+namespace sample_sort {
+
+const long kSerial = 1 << 16;      // ranges up to this size go to std::sort
+const int kMaxLogBuckets = 7;      // up to 128 splitter buckets, 255 with equality
+const long kChunk = 1 << 14;       // elements per classification chunk
+
+template <class It, class Comp>
+struct Sorter {
+    typedef typename std::iterator_traits<It>::value_type T;
+    It base;
+    std::vector<T> tmp;
+    std::vector<uint8_t> oracle;
+    Comp comp;
+
+    Sorter(It first, long n, Comp c) : base(first), tmp(n), oracle(n), comp(c) {}
+
+    // sorts base[lo, hi)
+    void Sort(long lo, long hi, int depth) {
+        long n = hi - lo;
+        if (n <= kSerial || depth > 8) {
+            std::sort(base + lo, base + hi, comp);
+            return;
+        }
+
+        int logk = kMaxLogBuckets;
+        while (logk > 1 && (n >> logk) < kSerial / 4)
+            logk--;
+        const int k = 1 << logk, buckets = 2 * k;
+
+        // splitters: every oversample-th element of a sorted random sample
+        int oversample = std::max(4, (int)(std::log2((double)n) / 2));
+        std::vector<T> sample;
+        sample.reserve(k * oversample);
+        std::mt19937_64 gen(lo * 31 + n);
+        std::uniform_int_distribution<long> pick(lo, hi - 1);
+        for (int i = 0; i < k * oversample; i++)
+            sample.push_back(base[pick(gen)]);
+        std::sort(sample.begin(), sample.end(), comp);
+        std::vector<T> splitter(k - 1);   // sorted
+        for (int i = 0; i < k - 1; i++)
+            splitter[i] = sample[(i + 1) * oversample - 1];
+
+        // implicit tree: node j has children 2j, 2j + 1, leaves k .. 2k-1
+        std::vector<T> tree(k);
+        BuildTree(tree, splitter, 1, 0, k - 1);
+
+        // classify: b = number of splitters < x, then bucket 2b + (x == splitter[b])
+        auto bucket_of = [&](const T& x) -> int {
+            int j = 1;
+            for (int l = 0; l < logk; l++)
+                j = 2 * j + (int)comp(tree[j], x);
+            int b = j - k;
+            int eq = (b < k - 1) & !comp(x, splitter[std::min(b, k - 2)]);
+            return 2 * b + eq;
+        };
+
+        long chunks = (n + kChunk - 1) / kChunk;
+        std::vector<long> count(chunks * buckets, 0);
+        oneapi::tbb::parallel_for(
+            oneapi::tbb::blocked_range<long>(0, chunks),
+            [&](const oneapi::tbb::blocked_range<long>& r) {
+                for (long c = r.begin(); c < r.end(); c++) {
+                    long* cnt = &count[c * buckets];
+                    for (long i = lo + c * kChunk; i < std::min(hi, lo + (c + 1) * kChunk); i++) {
+                        int b = bucket_of(base[i]);
+                        oracle[i] = (uint8_t)b;
+                        cnt[b]++;
+                    }
+                }
+            });
+
+        // bucket-major prefix: (chunk c, bucket b) starts after all smaller
+        // buckets and after bucket b of the chunks before c
+        std::vector<long> bucket_begin(buckets + 1, lo);
+        long pos = lo;
+        for (int b = 0; b < buckets; b++) {
+            bucket_begin[b] = pos;
+            for (long c = 0; c < chunks; c++) {
+                long v = count[c * buckets + b];
+                count[c * buckets + b] = pos;
+                pos += v;
+            }
+        }
+        bucket_begin[buckets] = hi;
+
+        oneapi::tbb::parallel_for(
+            oneapi::tbb::blocked_range<long>(0, chunks),
+            [&](const oneapi::tbb::blocked_range<long>& r) {
+                for (long c = r.begin(); c < r.end(); c++) {
+                    long* out = &count[c * buckets];
+                    for (long i = lo + c * kChunk; i < std::min(hi, lo + (c + 1) * kChunk); i++)
+                        tmp[out[oracle[i]]++] = std::move(base[i]);
+                }
+            });
+        oneapi::tbb::parallel_for(
+            oneapi::tbb::blocked_range<long>(lo, hi),
+            [&](const oneapi::tbb::blocked_range<long>& r) {
+                std::move(tmp.begin() + r.begin(), tmp.begin() + r.end(), base + r.begin());
+            });
+
+        // odd buckets hold elements equal to a splitter: already sorted
+        oneapi::tbb::task_group g;
+        for (int b = 0; b < buckets; b += 2) {
+            long blo = bucket_begin[b], bhi = bucket_begin[b + 1];
+            if (bhi - blo > 1)
+                g.run([this, blo, bhi, depth] { Sort(blo, bhi, depth + 1); });
+        }
+        g.wait();
+    }
+
+    static void BuildTree(std::vector<T>& tree, const std::vector<T>& s, int node, int lo, int hi) {
+        if (node >= (int)tree.size())
+            return;
+        int mid = (lo + hi) / 2;
+        tree[node] = s[mid];
+        BuildTree(tree, s, 2 * node, lo, mid);
+        BuildTree(tree, s, 2 * node + 1, mid + 1, hi);
+    }
+};
+
+} // namespace sample_sort
+
+template <class It, class Comp>
+void SampleSort(It first, It last, Comp comp)
+{
+    long n = last - first;
+    if (n <= sample_sort::kSerial) {
+        std::sort(first, last, comp);
+        return;
+    }
+    // already sorted input costs one parallel pass, as in tbb::parallel_sort
+    bool sorted = oneapi::tbb::parallel_reduce(
+        oneapi::tbb::blocked_range<long>(1, n, sample_sort::kChunk), true,
+        [&](const oneapi::tbb::blocked_range<long>& r, bool ok) {
+            for (long i = r.begin(); ok && i < r.end(); i++)
+                ok = !comp(first[i], first[i - 1]);
+            return ok;
+        },
+        [](bool a, bool b) { return a && b; });
+    if (sorted)
+        return;
+    sample_sort::Sorter<It, Comp> s(first, n, comp);
+    s.Sort(0, n, 0);
+}
+
+template <class It>
+void SampleSort(It first, It last)
+{
+    SampleSort(first, last, std::less<typename std::iterator_traits<It>::value_type>());
+}
+
+#endif
@@ -0,0 +1,396 @@
+// A small columnar query engine for
+//
+//     SELECT expr, ...  /  SUM(expr), COUNT(*), MIN(expr), MAX(expr)
+//     FROM table WHERE pred AND pred AND ...
+//
+// over int32 and float columns. It is the filter of 6_Example_PackingProblem
+// (map, scan, scatter) followed by a reduce, run as one pipeline:
+//
+//   morsels   the table is cut into morsels of kMorsel rows; TBB tasks take
+//             them one at a time (parallel_for, grain 1), so a slow morsel
+//             does not hold up a whole thread's static share
+//   vectors   inside a morsel everything works on vectors of kVector rows that
+//             stay in L1: the first predicate writes a selection vector (the
+//             indices of the matching rows, branch-free), every further
+//             predicate of the conjunction shrinks it, then the projections and
+//             aggregate inputs are computed only for the selected rows
+//   output    aggregates are kept per thread and merged at the end; projected
+//             rows are appended to a buffer of their morsel and the buffers are
+//             concatenated in morsel order, so the result is in table order
+//
+// Expressions are trees of columns, constants and + - *, evaluated a vector
+// at a time (one tight loop per node, no per-row interpretation).
+//
+//     Query q;
+//     q.where = {Pred("l_shipdate", Pred::GE, 8766), Pred("l_quantity", Pred::LT, 24)};
+//     q.aggregates = {Sum(Col("l_extendedprice") * Col("l_discount")), Count()};
+//     Result r = Execute(table, q);
+
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <oneapi/tbb/blocked_range.h>
+#include <oneapi/tbb/parallel_for.h>
+#include <oneapi/tbb/enumerable_thread_specific.h>
+
+namespace engine {
+
+const int kVector = 1024;
+const long kMorsel = 16 * kVector;
+
+struct Column {
+    enum Type { Int, Float } type;
+    std::vector<int32_t> ints;
+    std::vector<float> floats;
+};
+
+struct Table {
+    long rows = 0;
+    std::map<std::string, Column> columns;
+
+    std::vector<int32_t>& AddInt(const std::string& name) {
+        Column& c = columns[name];
+        c.type = Column::Int;
+        c.ints.resize(rows);
+        return c.ints;
+    }
+    std::vector<float>& AddFloat(const std::string& name) {
+        Column& c = columns[name];
+        c.type = Column::Float;
+        c.floats.resize(rows);
+        return c.floats;
+    }
+    const Column& Get(const std::string& name) const {
+        auto it = columns.find(name);
+        if (it == columns.end())
+            throw std::invalid_argument("no column " + name);
+        return it->second;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Query description
+// ---------------------------------------------------------------------------
+
+struct Pred {
+    enum Op { LT, LE, GT, GE, EQ, BETWEEN } op;   // BETWEEN: lo <= v <= hi
+    std::string column;
+    double lo, hi;
+
+    Pred(const std::string& c, Op o, double v, double v2 = 0) : op(o), column(c), lo(v), hi(v2) {}
+};
+
+struct ExprNode {
+    enum Kind { Col, Const, Add, Sub, Mul } kind;
+    std::string column;
+    double value = 0;
+    std::shared_ptr<ExprNode> a, b;
+};
+
+struct Expr {
+    std::shared_ptr<ExprNode> node;
+};
+
+inline Expr Col(const std::string& name)
+{
+    auto n = std::make_shared<ExprNode>();
+    n->kind = ExprNode::Col;
+    n->column = name;
+    return {n};
+}
+
+inline Expr Lit(double v)
+{
+    auto n = std::make_shared<ExprNode>();
+    n->kind = ExprNode::Const;
+    n->value = v;
+    return {n};
+}
+
+inline Expr Binary(ExprNode::Kind k, Expr a, Expr b)
+{
+    auto n = std::make_shared<ExprNode>();
+    n->kind = k;
+    n->a = a.node;
+    n->b = b.node;
+    return {n};
+}
+
+inline Expr operator+(Expr a, Expr b) { return Binary(ExprNode::Add, a, b); }
+inline Expr operator-(Expr a, Expr b) { return Binary(ExprNode::Sub, a, b); }
+inline Expr operator*(Expr a, Expr b) { return Binary(ExprNode::Mul, a, b); }
+
+struct Aggregate {
+    enum Kind { Sum, Count, Min, Max } kind;
+    Expr expr;
+};
+
+inline Aggregate Sum(Expr e) { return {Aggregate::Sum, e}; }
+inline Aggregate Min(Expr e) { return {Aggregate::Min, e}; }
+inline Aggregate Max(Expr e) { return {Aggregate::Max, e}; }
+inline Aggregate Count() { return {Aggregate::Count, Lit(1)}; }
+
+struct Query {
+    std::vector<Pred> where;
+    std::vector<Expr> select;          // projected columns
+    std::vector<Aggregate> aggregates;
+};
+
+struct Result {
+    long rows = 0;                                  // rows that passed WHERE
+    std::vector<std::vector<double>> columns;       // one per select expression
+    std::vector<double> aggregates;
+};
+
+// ---------------------------------------------------------------------------
+// Vector kernels
+// ---------------------------------------------------------------------------
+
+namespace detail {
+
+// selection vector of rows [0, n) of v where cmp holds
+template <class T, class Cmp>
+int SelectDense(const T* v, int n, Cmp cmp, uint16_t sel[])
+{
+    int k = 0;
+    for (int i = 0; i < n; i++) {
+        sel[k] = (uint16_t)i;
+        k += cmp(v[i]);
+    }
+    return k;
+}
+
+// keeps the entries of sel where cmp holds
+template <class T, class Cmp>
+int SelectRefine(const T* v, Cmp cmp, uint16_t sel[], int k)
+{
+    int m = 0;
+    for (int j = 0; j < k; j++) {
+        uint16_t i = sel[j];
+        sel[m] = i;
+        m += cmp(v[i]);
+    }
+    return m;
+}
+
+template <class T>
+int Select(const T* v, int n, const Pred& p, uint16_t sel[], int k, bool dense)
+{
+    auto run = [&](auto cmp) {
+        return dense ? SelectDense(v, n, cmp, sel) : SelectRefine(v, cmp, sel, k);
+    };
+    if constexpr (std::is_integral<T>::value) {
+        // every operator on an int column is an integer range [a, b]: x < 23.5
+        // is x <= 23, x >= 2.5 is x >= 3. The bounds are clamped to T before
+        // the conversion, an empty range selects nothing
+        double a = -HUGE_VAL, b = HUGE_VAL;
+        switch (p.op) {
+        case Pred::LT: b = std::ceil(p.lo) - 1; break;
+        case Pred::LE: b = std::floor(p.lo); break;
+        case Pred::GT: a = std::floor(p.lo) + 1; break;
+        case Pred::GE: a = std::ceil(p.lo); break;
+        case Pred::EQ: a = std::ceil(p.lo); b = std::floor(p.lo); break;
+        default:       a = std::ceil(p.lo); b = std::floor(p.hi); break;
+        }
+        a = std::max(a, (double)std::numeric_limits<T>::min());
+        b = std::min(b, (double)std::numeric_limits<T>::max());
+        if (!(a <= b))   // also NaN bounds
+            return 0;
+        const T lo = (T)a, hi = (T)b;
+        return run([lo, hi](T x) { return (x >= lo) & (x <= hi); });
+    }
+    // compare in the column type, so float columns are not widened
+    const T lo = (T)p.lo, hi = (T)p.hi;
+    switch (p.op) {
+    case Pred::LT: return run([lo](T x) { return x < lo; });
+    case Pred::LE: return run([lo](T x) { return x <= lo; });
+    case Pred::GT: return run([lo](T x) { return x > lo; });
+    case Pred::GE: return run([lo](T x) { return x >= lo; });
+    case Pred::EQ: return run([lo](T x) { return x == lo; });
+    default:       return run([lo, hi](T x) { return (x >= lo) & (x <= hi); });
+    }
+}
+
+// expression tree with the column pointers resolved
+struct Bound {
+    ExprNode::Kind kind;
+    const int32_t* ints = nullptr;
+    const float* floats = nullptr;
+    double value = 0;
+    std::unique_ptr<Bound> a, b;
+};
+
+inline std::unique_ptr<Bound> Bind(const Table& t, const ExprNode& e)
+{
+    std::unique_ptr<Bound> b(new Bound);
+    b->kind = e.kind;
+    b->value = e.value;
+    if (e.kind == ExprNode::Col) {
+        const Column& c = t.Get(e.column);
+        if (c.type == Column::Int) b->ints = c.ints.data();
+        else b->floats = c.floats.data();
+    } else if (e.kind != ExprNode::Const) {
+        b->a = Bind(t, *e.a);
+        b->b = Bind(t, *e.b);
+    }
+    return b;
+}
+
+// out[j] = e(row base + sel[j]) for j < k
+inline void Eval(const Bound& e, long base, const uint16_t sel[], int k, double out[])
+{
+    switch (e.kind) {
+    case ExprNode::Col:
+        if (e.ints) {
+            const int32_t* v = e.ints + base;
+            for (int j = 0; j < k; j++) out[j] = v[sel[j]];
+        } else {
+            const float* v = e.floats + base;
+            for (int j = 0; j < k; j++) out[j] = v[sel[j]];
+        }
+        return;
+    case ExprNode::Const:
+        std::fill(out, out + k, e.value);
+        return;
+    default:
+        break;
+    }
+    double rhs[kVector];
+    Eval(*e.a, base, sel, k, out);
+    Eval(*e.b, base, sel, k, rhs);
+    if (e.kind == ExprNode::Add)      for (int j = 0; j < k; j++) out[j] += rhs[j];
+    else if (e.kind == ExprNode::Sub) for (int j = 0; j < k; j++) out[j] -= rhs[j];
+    else                              for (int j = 0; j < k; j++) out[j] *= rhs[j];
+}
+
+inline double Identity(Aggregate::Kind k)
+{
+    if (k == Aggregate::Min) return std::numeric_limits<double>::infinity();
+    if (k == Aggregate::Max) return -std::numeric_limits<double>::infinity();
+    return 0;
+}
+
+inline double Combine(Aggregate::Kind k, double a, double b)
+{
+    if (k == Aggregate::Min) return std::min(a, b);
+    if (k == Aggregate::Max) return std::max(a, b);
+    return a + b;
+}
+
+} // namespace detail
+
+// ---------------------------------------------------------------------------
+
+inline Result Execute(const Table& t, const Query& q)
+{
+    struct BoundPred { const Column* col; Pred pred; };
+    std::vector<BoundPred> preds;
+    for (const Pred& p : q.where)
+        preds.push_back({&t.Get(p.column), p});
+    std::vector<std::unique_ptr<detail::Bound>> select, agg;
+    for (const Expr& e : q.select)
+        select.push_back(detail::Bind(t, *e.node));
+    for (const Aggregate& a : q.aggregates)
+        agg.push_back(detail::Bind(t, *a.expr.node));
+
+    const int nsel = select.size(), nagg = agg.size();
+    const long morsels = (t.rows + kMorsel - 1) / kMorsel;
+
+    struct Local {
+        std::vector<double> agg;
+        long rows = 0;
+    };
+    oneapi::tbb::enumerable_thread_specific<Local> local([&] {
+        Local l;
+        for (const Aggregate& a : q.aggregates)
+            l.agg.push_back(detail::Identity(a.kind));
+        return l;
+    });
+    // projected values of every morsel, [morsel][select column]
+    std::vector<std::vector<std::vector<double>>> out(nsel ? morsels : 0);
+
+    oneapi::tbb::parallel_for(
+        oneapi::tbb::blocked_range<long>(0, morsels, 1),
+        [&](const oneapi::tbb::blocked_range<long>& r) {
+            Local& l = local.local();
+            uint16_t sel[kVector];
+            double val[kVector];
+            for (long m = r.begin(); m != r.end(); ++m) {
+                if (nsel)
+                    out[m].resize(nsel);
+                for (long base = m * kMorsel; base < std::min(t.rows, (m + 1) * kMorsel); base += kVector) {
+                    int n = (int)std::min<long>(kVector, t.rows - base);
+                    int k = n;
+                    if (preds.empty())
+                        for (int i = 0; i < n; i++) sel[i] = (uint16_t)i;
+                    for (size_t p = 0; p < preds.size() && k > 0; p++) {
+                        const Column& c = *preds[p].col;
+                        k = c.type == Column::Int
+                            ? detail::Select(c.ints.data() + base, n, preds[p].pred, sel, k, p == 0)
+                            : detail::Select(c.floats.data() + base, n, preds[p].pred, sel, k, p == 0);
+                    }
+                    if (k == 0)
+                        continue;
+                    l.rows += k;
+                    for (int s = 0; s < nsel; s++) {
+                        detail::Eval(*select[s], base, sel, k, val);
+                        out[m][s].insert(out[m][s].end(), val, val + k);
+                    }
+                    for (int a = 0; a < nagg; a++) {
+                        Aggregate::Kind kind = q.aggregates[a].kind;
+                        if (kind == Aggregate::Count) {
+                            l.agg[a] += k;
+                            continue;
+                        }
+                        detail::Eval(*agg[a], base, sel, k, val);
+                        double acc = l.agg[a];
+                        if (kind == Aggregate::Sum)
+                            for (int j = 0; j < k; j++) acc += val[j];
+                        else
+                            for (int j = 0; j < k; j++) acc = detail::Combine(kind, acc, val[j]);
+                        l.agg[a] = acc;
+                    }
+                }
+            }
+        });
+
+    Result res;
+    for (const Aggregate& a : q.aggregates)
+        res.aggregates.push_back(detail::Identity(a.kind));
+    for (const Local& l : local) {
+        res.rows += l.rows;
+        for (int a = 0; a < nagg; a++)
+            res.aggregates[a] = detail::Combine(q.aggregates[a].kind, res.aggregates[a], l.agg[a]);
+    }
+
+    // concatenate the morsel outputs in table order
+    if (nsel) {
+        std::vector<long> offset(morsels + 1, 0);
+        for (long m = 0; m < morsels; m++)
+            offset[m + 1] = offset[m] + (long)out[m][0].size();
+        res.columns.assign(nsel, std::vector<double>(offset[morsels]));
+        oneapi::tbb::parallel_for(
+            oneapi::tbb::blocked_range<long>(0, morsels, 1),
+            [&](const oneapi::tbb::blocked_range<long>& r) {
+                for (long m = r.begin(); m != r.end(); ++m)
+                    for (int s = 0; s < nsel; s++)
+                        std::copy(out[m][s].begin(), out[m][s].end(), res.columns[s].begin() + offset[m]);
+            });
+    }
+    return res;
+}
+
+} // namespace engine
+
+#endif
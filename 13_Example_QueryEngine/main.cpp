@@ -0,0 +1,217 @@
+// Queries of engine.h on a synthetic TPC-H-like lineitem table.
+//
+// Columns follow the TPC-H generator ranges: l_quantity 1..50,
+// l_extendedprice = quantity * part price (900..2000), l_discount 0..0.10,
+// l_tax 0..0.08, l_shipdate in days since 1970 over 1992-01-02..1998-12-01,
+// l_returnflag / l_linestatus as small integer codes. 6,000,000 rows is
+// about scale factor 1.
+//
+// Every query is also computed by a plain serial loop over the rows and the
+// results are compared (sums up to rounding, since the summation order
+// differs). Reported: time and rows scanned per second.
+//
+// g++ -O3 -march=native -std=c++17 main.cpp -pthread -ltbb
+// ./a.out [rows]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <string>
+#include <cmath>
+#include <functional>
+
+#include <tbb/tbb.h>
+#include "oneapi/tbb/blocked_range.h"
+#include "oneapi/tbb/parallel_for.h"
+
+#include "engine.h"
+
+using namespace std;
+using namespace oneapi;
+using namespace engine;
+
+const int kDay19920102 = 8036, kDay19981201 = 10561;
+const int kDay19940101 = 8766, kDay19950101 = 9131, kDay19980902 = 10471;
+
+Table Lineitem(long rows)
+{
+    Table t;
+    t.rows = rows;
+    auto& quantity = t.AddInt("l_quantity");
+    auto& price = t.AddFloat("l_extendedprice");
+    auto& discount = t.AddFloat("l_discount");
+    auto& tax = t.AddFloat("l_tax");
+    auto& shipdate = t.AddInt("l_shipdate");
+    auto& returnflag = t.AddInt("l_returnflag");
+    auto& linestatus = t.AddInt("l_linestatus");
+
+    // one generator per block of rows, so the table does not depend on the
+    // number of threads
+    const long block = 1 << 16;
+    tbb::parallel_for(
+        tbb::blocked_range<long>(0, (rows + block - 1) / block),
+        [&](tbb::blocked_range<long> r) {
+            for (long b = r.begin(); b < r.end(); b++) {
+                mt19937 gen(b);
+                uniform_int_distribution<int> q(1, 50), cents(90000, 200000), d(0, 10), x(0, 8),
+                                              day(kDay19920102, kDay19981201), flag(0, 2);
+                for (long i = b * block; i < min(rows, (b + 1) * block); i++) {
+                    quantity[i] = q(gen);
+                    price[i] = quantity[i] * cents(gen) / 100.0f;
+                    discount[i] = d(gen) / 100.0f;
+                    tax[i] = x(gen) / 100.0f;
+                    shipdate[i] = day(gen);
+                    linestatus[i] = shipdate[i] > 9298;      // shipped after 1995-06-17
+                    returnflag[i] = linestatus[i] ? 2 : flag(gen) % 2;
+                }
+            }
+        });
+    return t;
+}
+
+struct Case {
+    string name;
+    Query query;
+    // serial reference: called for every row, returns whether it matches and
+    // fills the projected values and aggregate inputs
+    function<bool(long, vector<double>&, vector<double>&)> row;
+};
+
+bool Close(double a, double b)
+{
+    return a == b || fabs(a - b) <= 1e-9 * max(fabs(a), fabs(b));
+}
+
+void Run(const Table& t, const Case& c)
+{
+    const Query& q = c.query;
+    Result r;
+    double secs = 1e30;
+    for (int rep = 0; rep < 3; rep++) {
+        tbb::tick_count t0 = tbb::tick_count::now();
+        r = Execute(t, q);
+        secs = min(secs, (tbb::tick_count::now() - t0).seconds());
+    }
+
+    // serial reference
+    tbb::tick_count t0 = tbb::tick_count::now();
+    long rows = 0;
+    vector<double> agg;
+    for (const Aggregate& a : q.aggregates)
+        agg.push_back(a.kind == Aggregate::Min ? INFINITY : a.kind == Aggregate::Max ? -INFINITY : 0.0);
+    vector<vector<double>> cols(q.select.size());
+    vector<double> proj(q.select.size()), in(q.aggregates.size());
+    for (long i = 0; i < t.rows; i++) {
+        if (!c.row(i, proj, in))
+            continue;
+        rows++;
+        for (size_t s = 0; s < proj.size(); s++)
+            cols[s].push_back(proj[s]);
+        for (size_t a = 0; a < in.size(); a++) {
+            Aggregate::Kind k = q.aggregates[a].kind;
+            if (k == Aggregate::Sum) agg[a] += in[a];
+            else if (k == Aggregate::Count) agg[a] += 1;
+            else if (k == Aggregate::Min) agg[a] = min(agg[a], in[a]);
+            else agg[a] = max(agg[a], in[a]);
+        }
+    }
+    double serial = (tbb::tick_count::now() - t0).seconds();
+
+    bool ok = rows == r.rows && cols.size() == r.columns.size();
+    for (size_t s = 0; ok && s < cols.size(); s++)
+        ok = cols[s].size() == r.columns[s].size()
+             && equal(cols[s].begin(), cols[s].end(), r.columns[s].begin(), Close);
+    for (size_t a = 0; ok && a < agg.size(); a++)
+        ok = Close(agg[a], r.aggregates[a]);
+
+    cout << c.name << endl << "  " << r.rows << " rows (" << fixed << setprecision(2)
+         << 100.0 * r.rows / t.rows << "%)";
+    for (double v : r.aggregates)
+        cout << "  " << setprecision(2) << v;
+    cout << endl << "  engine " << setprecision(2) << secs * 1e3 << " ms, "
+         << setprecision(1) << t.rows / secs * 1e-6 << " M rows/s;  serial loop "
+         << setprecision(2) << serial * 1e3 << " ms" << (ok ? "" : "   MISMATCH") << endl << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    long n = argc > 1 ? atol(argv[1]) : 6000000;
+    cout << "Default concurrency " << tbb::info::default_concurrency() << endl;
+    Table t = Lineitem(n);
+    cout << "lineitem: " << n << " rows, " << t.columns.size() << " columns" << endl << endl;
+
+    const auto& quantity = t.Get("l_quantity").ints;
+    const auto& price = t.Get("l_extendedprice").floats;
+    const auto& discount = t.Get("l_discount").floats;
+    const auto& tax = t.Get("l_tax").floats;
+    const auto& shipdate = t.Get("l_shipdate").ints;
+    const auto& returnflag = t.Get("l_returnflag").ints;
+    vector<Case> cases;
+
+    // TPC-H Q6, forecasting revenue change
+    Case q6;
+    q6.name = "Q6: SUM(price * discount), COUNT(*) WHERE shipdate in [1994, 1995) "
+              "AND discount BETWEEN 0.05 AND 0.07 AND quantity < 24";
+    q6.query.where = {Pred("l_shipdate", Pred::GE, kDay19940101),
+                      Pred("l_shipdate", Pred::LT, kDay19950101),
+                      Pred("l_discount", Pred::BETWEEN, 0.05, 0.07),
+                      Pred("l_quantity", Pred::LT, 24)};
+    q6.query.aggregates = {Sum(Col("l_extendedprice") * Col("l_discount")), Count()};
+    q6.row = [&](long i, vector<double>&, vector<double>& in) {
+        if (!(shipdate[i] >= kDay19940101 && shipdate[i] < kDay19950101 && discount[i] >= 0.05f
+              && discount[i] <= 0.07f && quantity[i] < 24))
+            return false;
+        in = {(double)price[i] * (double)discount[i], 1.0};
+        return true;
+    };
+    cases.push_back(q6);
+
+    // TPC-H Q1 without the GROUP BY, pricing summary
+    Case q1;
+    q1.name = "Q1 (no group by): SUM(qty), SUM(price), SUM(price*(1-disc)), "
+              "SUM(price*(1-disc)*(1+tax)), MIN/MAX(price), COUNT(*) WHERE shipdate <= 1998-09-02";
+    q1.query.where = {Pred("l_shipdate", Pred::LE, kDay19980902)};
+    Expr disc_price = Col("l_extendedprice") * (Lit(1) - Col("l_discount"));
+    q1.query.aggregates = {Sum(Col("l_quantity")), Sum(Col("l_extendedprice")), Sum(disc_price),
+                           Sum(disc_price * (Lit(1) + Col("l_tax"))),
+                           Min(Col("l_extendedprice")), Max(Col("l_extendedprice")), Count()};
+    q1.row = [&](long i, vector<double>&, vector<double>& in) {
+        if (!(shipdate[i] <= kDay19980902))
+            return false;
+        double dp = (double)price[i] * (1.0 - (double)discount[i]);
+        in = {(double)quantity[i], (double)price[i], dp, dp * (1.0 + (double)tax[i]),
+              (double)price[i], (double)price[i], 1.0};
+        return true;
+    };
+    cases.push_back(q1);
+
+    // projection: the rows themselves, in table order
+    Case proj;
+    proj.name = "SELECT shipdate, price, price*(1-disc) WHERE quantity >= 45 AND returnflag = 1";
+    proj.query.where = {Pred("l_quantity", Pred::GE, 45), Pred("l_returnflag", Pred::EQ, 1)};
+    proj.query.select = {Col("l_shipdate"), Col("l_extendedprice"), disc_price};
+    proj.query.aggregates = {Count()};
+    proj.row = [&](long i, vector<double>& out, vector<double>& in) {
+        if (!(quantity[i] >= 45 && returnflag[i] == 1))
+            return false;
+        out = {(double)shipdate[i], (double)price[i], (double)price[i] * (1.0 - (double)discount[i])};
+        in = {1.0};
+        return true;
+    };
+    cases.push_back(proj);
+
+    // no predicate: pure aggregation bandwidth
+    Case all;
+    all.name = "SUM(price * (1 + tax)) over all rows";
+    all.query.aggregates = {Sum(Col("l_extendedprice") * (Lit(1) + Col("l_tax")))};
+    all.row = [&](long i, vector<double>&, vector<double>& in) {
+        in = {(double)price[i] * (1.0 + (double)tax[i])};
+        return true;
+    };
+    cases.push_back(all);
+
+    for (const Case& c : cases)
+        Run(t, c);
+    return 0;
+}
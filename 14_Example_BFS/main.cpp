@@ -0,0 +1,369 @@
+// Parallel breadth-first search on RMAT (Graph500 Kronecker) graphs in CSR
+// form, reported in TEPS (traversed edges per second, Graph500 style: the
+// undirected edges inside the reached component divided by the search time).
+//
+//   top-down    the frontier is a list of vertices. Every chunk of it claims
+//               unvisited neighbours in an atomic visited bitmap (fetch_or, the
+//               thread that sets the bit owns the vertex) and collects them in
+//               a chunk-local list; the next frontier is put together with the
+//               MAP / SCAN / scatter steps of 6_Example_PackingProblem: count
+//               per chunk, prefix over the counts, copy to the offsets.
+//   bottom-up   the frontier is a bitmap. Every unvisited vertex looks for a
+//               parent among its neighbours and stops at the first one in the
+//               frontier. Tasks own whole 64-vertex words of the next
+//               bitmap, so no atomics are needed.
+//   direction-  Beamer's heuristic: switch to bottom-up when the edges out of
+//   optimizing  the frontier exceed the edges of unvisited vertices / alpha,
+//               back to top-down when the frontier drops below n / beta.
+//
+// Every search is checked against a serial BFS: same reached set, and every
+// parent is a neighbour one level closer to the root.
+//
+// g++ -O3 -march=native -std=c++17 main.cpp -pthread -ltbb
+// ./a.out [max scale] [edge factor]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <string>
+#include <cstdint>
+
+#include <tbb/tbb.h>
+#include "oneapi/tbb/blocked_range.h"
+#include "oneapi/tbb/parallel_for.h"
+#include "oneapi/tbb/parallel_reduce.h"
+#include "oneapi/tbb/parallel_sort.h"
+
+using namespace std;
+using namespace oneapi;
+
+struct Graph {
+    int n;
+    vector<long> row;   // row[v] .. row[v+1] index adj
+    vector<int> adj;
+    long degree(int v) const { return row[v + 1] - row[v]; }
+};
+
+// undirected RMAT graph with 2^scale vertices and edge_factor * 2^scale
+// generated edges; self loops and duplicates are removed
+Graph Rmat(int scale, int edge_factor)
+{
+    const double A = 0.57, B = 0.19, C = 0.19;
+    int n = 1 << scale;
+    long m = (long)edge_factor * n;
+    vector<uint64_t> e(2 * m);
+    const long block = 1 << 16;
+
+    tbb::parallel_for(
+        tbb::blocked_range<long>(0, (m + block - 1) / block),
+        [&](tbb::blocked_range<long> r) {
+            for (long b = r.begin(); b < r.end(); b++) {
+                mt19937_64 gen(b * 7919 + scale);
+                uniform_real_distribution<double> u(0.0, 1.0);
+                for (long k = b * block; k < min(m, (b + 1) * block); k++) {
+                    uint64_t s = 0, t = 0;
+                    for (int level = 0; level < scale; level++) {
+                        double p = u(gen);
+                        int bs = p >= A + B, bt = (p >= A && p < A + B) || p >= A + B + C;
+                        s = 2 * s + bs;
+                        t = 2 * t + bt;
+                    }
+                    e[2 * k] = s << 32 | t;
+                    e[2 * k + 1] = t << 32 | s;
+                }
+            }
+        });
+
+    // scramble the vertex numbers, otherwise the high-degree vertices are
+    // the low numbers
+    vector<uint32_t> perm(n);
+    for (int v = 0; v < n; v++) perm[v] = v;
+    shuffle(perm.begin(), perm.end(), mt19937(scale));
+    tbb::parallel_for(tbb::blocked_range<long>(0, e.size()), [&](tbb::blocked_range<long> r) {
+        for (long k = r.begin(); k < r.end(); k++)
+            e[k] = (uint64_t)perm[e[k] >> 32] << 32 | perm[(uint32_t)e[k]];
+    });
+
+    tbb::parallel_sort(e.begin(), e.end());
+    e.erase(unique(e.begin(), e.end()), e.end());
+    e.erase(remove_if(e.begin(), e.end(), [](uint64_t x) { return (x >> 32) == (uint32_t)x; }), e.end());
+
+    Graph g;
+    g.n = n;
+    g.row.assign(n + 1, 0);
+    g.adj.resize(e.size());
+    for (size_t k = 0; k < e.size(); k++) {
+        g.row[(e[k] >> 32) + 1]++;
+        g.adj[k] = (uint32_t)e[k];
+    }
+    for (int v = 0; v < n; v++)
+        g.row[v + 1] += g.row[v];
+    return g;
+}
+
+// ---------------------------------------------------------------------------
+
+struct Bfs {
+    const Graph& g;
+    vector<int> parent;
+    vector<atomic<uint64_t>> visited;
+    vector<uint64_t> front_bits, next_bits;
+    vector<int> front;
+    int top_down_steps = 0, bottom_up_steps = 0;
+
+    Bfs(const Graph& graph)
+        : g(graph), parent(graph.n), visited((graph.n + 63) / 64),
+          front_bits((graph.n + 63) / 64), next_bits((graph.n + 63) / 64) {}
+
+    // true if this call marked v
+    bool Claim(int v) {
+        uint64_t bit = 1ULL << (v & 63);
+        if (visited[v >> 6].load(memory_order_relaxed) & bit)
+            return false;
+        return !(visited[v >> 6].fetch_or(bit, memory_order_relaxed) & bit);
+    }
+
+    void TopDown() {
+        const long CHUNK = 256;
+        long nf = front.size(), chunks = (nf + CHUNK - 1) / CHUNK;
+        vector<vector<int>> found(chunks);
+        vector<long> offset(chunks + 1, 0);
+
+        // MAP: every chunk of the frontier collects the vertices it claimed
+        tbb::parallel_for(
+            tbb::blocked_range<long>(0, chunks),
+            [&](tbb::blocked_range<long> r) {
+                for (long c = r.begin(); c < r.end(); c++) {
+                    vector<int>& out = found[c];
+                    for (long i = c * CHUNK; i < min(nf, (c + 1) * CHUNK); i++) {
+                        int u = front[i];
+                        for (long k = g.row[u]; k < g.row[u + 1]; k++) {
+                            int v = g.adj[k];
+                            if (Claim(v)) {
+                                parent[v] = u;
+                                out.push_back(v);
+                            }
+                        }
+                    }
+                    offset[c + 1] = out.size();
+                }
+            });
+        // SCAN
+        for (long c = 0; c < chunks; c++)
+            offset[c + 1] += offset[c];
+        // scatter
+        vector<int> next(offset[chunks]);
+        tbb::parallel_for(
+            tbb::blocked_range<long>(0, chunks),
+            [&](tbb::blocked_range<long> r) {
+                for (long c = r.begin(); c < r.end(); c++)
+                    copy(found[c].begin(), found[c].end(), next.begin() + offset[c]);
+            });
+        front.swap(next);
+        top_down_steps++;
+    }
+
+    // returns the size of the new frontier
+    long BottomUp() {
+        long words = front_bits.size();
+        long nf = tbb::parallel_reduce(
+            tbb::blocked_range<long>(0, words), 0L,
+            [&](tbb::blocked_range<long> r, long cnt) {
+                for (long w = r.begin(); w < r.end(); w++) {
+                    uint64_t done = visited[w].load(memory_order_relaxed), found = 0;
+                    for (uint64_t todo = ~done; todo; todo &= todo - 1) {
+                        int v = 64 * w + __builtin_ctzll(todo);
+                        if (v >= g.n)
+                            break;
+                        for (long k = g.row[v]; k < g.row[v + 1]; k++) {
+                            int u = g.adj[k];
+                            if (front_bits[u >> 6] >> (u & 63) & 1) {
+                                parent[v] = u;
+                                found |= 1ULL << (v & 63);
+                                break;
+                            }
+                        }
+                    }
+                    next_bits[w] = found;
+                    visited[w].store(done | found, memory_order_relaxed);
+                    cnt += __builtin_popcountll(found);
+                }
+                return cnt;
+            },
+            [](long a, long b) { return a + b; });
+        front_bits.swap(next_bits);
+        bottom_up_steps++;
+        return nf;
+    }
+
+    void QueueToBitmap() {
+        fill(front_bits.begin(), front_bits.end(), 0);
+        tbb::parallel_for(tbb::blocked_range<long>(0, front.size()), [&](tbb::blocked_range<long> r) {
+            for (long i = r.begin(); i < r.end(); i++)
+                __atomic_fetch_or(&front_bits[front[i] >> 6], 1ULL << (front[i] & 63), __ATOMIC_RELAXED);
+        });
+    }
+
+    // popcount per block of words, prefix, then every block writes its vertices
+    void BitmapToQueue() {
+        const long W = 1024;
+        long words = front_bits.size(), blocks = (words + W - 1) / W;
+        vector<long> offset(blocks + 1, 0);
+        tbb::parallel_for(tbb::blocked_range<long>(0, blocks), [&](tbb::blocked_range<long> r) {
+            for (long b = r.begin(); b < r.end(); b++) {
+                long c = 0;
+                for (long w = b * W; w < min(words, (b + 1) * W); w++)
+                    c += __builtin_popcountll(front_bits[w]);
+                offset[b + 1] = c;
+            }
+        });
+        for (long b = 0; b < blocks; b++)
+            offset[b + 1] += offset[b];
+        front.resize(offset[blocks]);
+        tbb::parallel_for(tbb::blocked_range<long>(0, blocks), [&](tbb::blocked_range<long> r) {
+            for (long b = r.begin(); b < r.end(); b++) {
+                int* dst = front.data() + offset[b];
+                for (long w = b * W; w < min(words, (b + 1) * W); w++)
+                    for (uint64_t m = front_bits[w]; m; m &= m - 1)
+                        *dst++ = 64 * w + __builtin_ctzll(m);
+            }
+        });
+    }
+
+    long FrontierEdges() {
+        return tbb::parallel_reduce(
+            tbb::blocked_range<long>(0, front.size()), 0L,
+            [&](tbb::blocked_range<long> r, long s) {
+                for (long i = r.begin(); i < r.end(); i++)
+                    s += g.degree(front[i]);
+                return s;
+            },
+            [](long a, long b) { return a + b; });
+    }
+
+    void Run(int root, bool direction_optimizing, double alpha = 14, double beta = 24) {
+        tbb::parallel_for(tbb::blocked_range<long>(0, g.n), [&](tbb::blocked_range<long> r) {
+            for (long v = r.begin(); v < r.end(); v++)
+                parent[v] = -1;
+        });
+        for (auto& w : visited)
+            w.store(0, memory_order_relaxed);
+        top_down_steps = bottom_up_steps = 0;
+        parent[root] = root;
+        visited[root >> 6].store(1ULL << (root & 63));
+        front.assign(1, root);
+
+        long unexplored = g.row[g.n];   // edges of unvisited vertices
+        bool bottom_up = false;
+        long nf = 1;
+        while (nf > 0) {
+            if (!bottom_up) {
+                long mf = FrontierEdges();
+                unexplored -= mf;
+                if (direction_optimizing && mf > unexplored / alpha) {
+                    QueueToBitmap();
+                    bottom_up = true;
+                }
+            } else if (nf < g.n / beta) {
+                BitmapToQueue();
+                bottom_up = false;
+            }
+            if (bottom_up) {
+                nf = BottomUp();
+            } else {
+                TopDown();
+                nf = front.size();
+            }
+        }
+    }
+};
+
+// levels of a serial BFS, -1 when unreached
+vector<int> SerialLevels(const Graph& g, int root)
+{
+    vector<int> level(g.n, -1), queue(1, root);
+    level[root] = 0;
+    for (size_t h = 0; h < queue.size(); h++) {
+        int u = queue[h];
+        for (long k = g.row[u]; k < g.row[u + 1]; k++)
+            if (level[g.adj[k]] < 0) {
+                level[g.adj[k]] = level[u] + 1;
+                queue.push_back(g.adj[k]);
+            }
+    }
+    return level;
+}
+
+bool Check(const Graph& g, int root, const vector<int>& parent, const vector<int>& level)
+{
+    for (int v = 0; v < g.n; v++) {
+        if ((parent[v] < 0) != (level[v] < 0))
+            return false;
+        if (parent[v] < 0 || v == root)
+            continue;
+        int p = parent[v];
+        if (level[p] != level[v] - 1)
+            return false;
+        if (!binary_search(g.adj.begin() + g.row[v], g.adj.begin() + g.row[v + 1], p))
+            return false;
+    }
+    return parent[root] == root;
+}
+
+int main(int argc, char* argv[])
+{
+    int max_scale = argc > 1 ? atoi(argv[1]) : 20;
+    int edge_factor = argc > 2 ? atoi(argv[2]) : 16;
+    const int roots = 8;
+    cout << "Default concurrency " << tbb::info::default_concurrency() << endl;
+    cout << "RMAT graphs, edge factor " << edge_factor << ", " << roots
+         << " roots per graph, harmonic mean of TEPS" << endl << endl;
+    cout << setw(6) << "scale" << setw(12) << "vertices" << setw(12) << "edges"
+         << setw(14) << "top-down" << setw(16) << "direction-opt" << setw(12) << "TD/BU steps"
+         << "   (10^6 TEPS)" << endl;
+
+    for (int scale = 14; scale <= max_scale; scale += 2) {
+        Graph g = Rmat(scale, edge_factor);
+        Bfs bfs(g);
+        mt19937 gen(scale);
+        uniform_int_distribution<int> pick(0, g.n - 1);
+        double inv_td = 0, inv_do = 0;
+        int td_steps = 0, bu_steps = 0;
+        bool ok = true;
+
+        for (int r = 0; r < roots; r++) {
+            int root;
+            do root = pick(gen); while (g.degree(root) == 0);
+            vector<int> level = SerialLevels(g, root);
+            long edges = 0;
+            for (int v = 0; v < g.n; v++)
+                if (level[v] >= 0)
+                    edges += g.degree(v);
+            edges /= 2;
+
+            tbb::tick_count t0 = tbb::tick_count::now();
+            bfs.Run(root, false);
+            double t_td = (tbb::tick_count::now() - t0).seconds();
+            ok = ok && Check(g, root, bfs.parent, level);
+
+            t0 = tbb::tick_count::now();
+            bfs.Run(root, true);
+            double t_do = (tbb::tick_count::now() - t0).seconds();
+            ok = ok && Check(g, root, bfs.parent, level);
+
+            inv_td += t_td / edges;
+            inv_do += t_do / edges;
+            td_steps += bfs.top_down_steps;
+            bu_steps += bfs.bottom_up_steps;
+        }
+        cout << setw(6) << scale << setw(12) << g.n << setw(12) << g.row[g.n] / 2
+             << fixed << setprecision(1) << setw(14) << roots / inv_td * 1e-6
+             << setw(16) << roots / inv_do * 1e-6
+             << setw(8) << (double)td_steps / roots << "/" << (double)bu_steps / roots
+             << (ok ? "" : "   INVALID") << endl;
+    }
+    return 0;
+}
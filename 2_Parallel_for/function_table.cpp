@@ -0,0 +1,206 @@
+#include <oneapi/tbb/info.h>
+#include <oneapi/tbb/parallel_for.h>
+#include <oneapi/tbb/parallel_reduce.h>
+#include <oneapi/tbb/tick_count.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Tables of sin/cos/exp on an evenly spaced grid x_i = x0 + i*h, built on
+// the same parallel_for as main.cpp. Instead of one libm call per element,
+// every block of `reseed` elements computes one exact seed and advances with
+// a recurrence:
+//
+//   rotation  (sin and cos)  c' = c - (a*c + b*s),  s' = s - (a*s - b*c)
+//                            a = 2 sin^2(h/2), b = sin(h)   (Numerical Recipes 5.4)
+//   chebyshev (sin only)     s_{k+1} = 2 cos(h) s_k - s_{k-1}
+//   geometric (exp)          e_{k+1} = e_k * exp(h)
+//
+// Rounding errors accumulate with the distance to the seed, so blocks are
+// re-seeded every `reseed` elements. Block boundaries are multiples of
+// `reseed` in absolute index, so the table does not depend on how TBB splits
+// the range.
+//
+// Seeds are evaluated in long double at the exact grid point. Errors are
+// measured against sinl/cosl/expl of the exact grid point too: std::sin(i * h)
+// is itself off by the rounding of i * h (about |x| * 1e-16), which for large
+// x is more than the recurrence error.
+//
+// g++ -O3 -march=native -std=c++17 function_table.cpp -pthread -ltbb
+// ./a.out [n]
+
+template <class Block>
+void ForEachSeedBlock(long n, long reseed, Block block)
+{
+    oneapi::tbb::parallel_for(
+        oneapi::tbb::blocked_range<long>(0, (n + reseed - 1) / reseed),
+        [&](oneapi::tbb::blocked_range<long> r) {
+            for (long b = r.begin(); b < r.end(); b++)
+                block(b * reseed, std::min(n, (b + 1) * reseed));
+        }
+    );
+}
+
+void SinCosRotation(double x0, double h, long n, long reseed, double sin_out[], double cos_out[])
+{
+    const double a = 2.0 * std::sin(0.5 * h) * std::sin(0.5 * h);
+    const double b = std::sin(h);
+    ForEachSeedBlock(n, reseed, [&](long first, long last) {
+        long double x = x0 + first * (long double)h;
+        double s = sinl(x), c = cosl(x);
+        for (long i = first; i < last; i++) {
+            sin_out[i] = s;
+            cos_out[i] = c;
+            double dc = a * c + b * s;
+            double ds = a * s - b * c;
+            c -= dc;
+            s -= ds;
+        }
+    });
+}
+
+void SinChebyshev(double x0, double h, long n, long reseed, double sin_out[])
+{
+    const double two_cos_h = 2.0 * std::cos(h);
+    ForEachSeedBlock(n, reseed, [&](long first, long last) {
+        double prev = sinl(x0 + (first - 1) * (long double)h);
+        double s = sinl(x0 + first * (long double)h);
+        for (long i = first; i < last; i++) {
+            sin_out[i] = s;
+            double next = two_cos_h * s - prev;
+            prev = s;
+            s = next;
+        }
+    });
+}
+
+void ExpGeometric(double x0, double h, long n, long reseed, double exp_out[])
+{
+    const double q = std::exp(h);
+    ForEachSeedBlock(n, reseed, [&](long first, long last) {
+        double e = expl(x0 + first * (long double)h);
+        for (long i = first; i < last; i++) {
+            exp_out[i] = e;
+            e *= q;
+        }
+    });
+}
+
+// ---------------------------------------------------------------------------
+
+template <class F>
+double Time(int reps, F f)
+{
+    f();
+    oneapi::tbb::tick_count t0 = oneapi::tbb::tick_count::now();
+    for (int r = 0; r < reps; r++)
+        f();
+    return (oneapi::tbb::tick_count::now() - t0).seconds() / reps;
+}
+
+// max |table - ref| (absolute for sin/cos, relative when rel is set)
+double MaxError(const std::vector<double>& t, const std::vector<double>& ref, bool rel)
+{
+    return oneapi::tbb::parallel_reduce(
+        oneapi::tbb::blocked_range<long>(0, t.size()), 0.0,
+        [&](oneapi::tbb::blocked_range<long> r, double e) {
+            for (long i = r.begin(); i < r.end(); i++) {
+                double d = std::fabs(t[i] - ref[i]);
+                e = std::max(e, rel ? d / std::fabs(ref[i]) : d);
+            }
+            return e;
+        },
+        [](double a, double b) { return std::max(a, b); });
+}
+
+int main(int argc, char* argv[]) {
+    long n = argc > 1 ? atol(argv[1]) : 10000000;
+    const double x0 = 0.0, h = 0.001; // the grid of main.cpp: sin(i * 0.001)
+    int num_threads = oneapi::tbb::info::default_concurrency();
+    std::cout << "Default concurrency " << num_threads << std::endl;
+
+    std::vector<double> ref_sin(n), ref_cos(n), ref_exp(n), s(n), c(n), e(n);
+    const double he = 1e-6; // exp grid kept in range: x in [0, n*1e-6]
+
+    oneapi::tbb::parallel_for(oneapi::tbb::blocked_range<long>(0, n),
+        [&](oneapi::tbb::blocked_range<long> r) {
+            for (long i = r.begin(); i < r.end(); i++) {
+                ref_sin[i] = sinl(x0 + i * (long double)h);
+                ref_cos[i] = cosl(x0 + i * (long double)h);
+                ref_exp[i] = expl(i * (long double)he);
+            }
+        });
+
+    // per-element libm, as in main.cpp
+    double t_sin = Time(3, [&] {
+        oneapi::tbb::parallel_for(oneapi::tbb::blocked_range<long>(0, n),
+            [&](oneapi::tbb::blocked_range<long> r) {
+                for (long i = r.begin(); i < r.end(); i++)
+                    s[i] = std::sin(x0 + i * h);
+            });
+    });
+    double e_sin = MaxError(s, ref_sin, false);
+    double t_sincos = Time(3, [&] {
+        oneapi::tbb::parallel_for(oneapi::tbb::blocked_range<long>(0, n),
+            [&](oneapi::tbb::blocked_range<long> r) {
+                for (long i = r.begin(); i < r.end(); i++) {
+                    s[i] = std::sin(x0 + i * h);
+                    c[i] = std::cos(x0 + i * h);
+                }
+            });
+    });
+    double e_sincos = std::max(MaxError(s, ref_sin, false), MaxError(c, ref_cos, false));
+    double t_exp = Time(3, [&] {
+        oneapi::tbb::parallel_for(oneapi::tbb::blocked_range<long>(0, n),
+            [&](oneapi::tbb::blocked_range<long> r) {
+                for (long i = r.begin(); i < r.end(); i++)
+                    e[i] = std::exp(i * he);
+            });
+    });
+    double e_exp = MaxError(e, ref_exp, true);
+
+    std::cout << "n = " << n << ", x up to " << n * h << " (sin/cos), " << n * he << " (exp)"
+              << std::endl << std::endl;
+    std::cout << std::setw(8) << "reseed"
+              << std::setw(22) << "rotation sin+cos" << std::setw(22) << "chebyshev sin"
+              << std::setw(22) << "geometric exp" << std::endl;
+    std::cout << std::setw(8) << " " << std::setw(22) << "speedup  max abs err"
+              << std::setw(22) << "speedup  max abs err" << std::setw(22) << "speedup  max rel err"
+              << std::endl;
+    std::cout << std::setw(8) << "libm" << std::scientific << std::setprecision(2)
+              << std::setw(22) << e_sincos << std::setw(22) << e_sin << std::setw(22) << e_exp
+              << std::endl;
+
+    for (long reseed : {16L, 64L, 256L, 1024L, 4096L, 16384L}) {
+        double tr = Time(3, [&] { SinCosRotation(x0, h, n, reseed, &s[0], &c[0]); });
+        double er = std::max(MaxError(s, ref_sin, false), MaxError(c, ref_cos, false));
+        double tc = Time(3, [&] { SinChebyshev(x0, h, n, reseed, &s[0]); });
+        double ec = MaxError(s, ref_sin, false);
+        double te = Time(3, [&] { ExpGeometric(0.0, he, n, reseed, &e[0]); });
+        double ee = MaxError(e, ref_exp, true);
+        std::cout << std::setw(8) << reseed << std::fixed << std::setprecision(1)
+                  << std::setw(9) << t_sincos / tr << "x" << std::scientific << std::setprecision(2)
+                  << std::setw(12) << er
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(9) << t_sin / tc << "x" << std::scientific << std::setprecision(2)
+                  << std::setw(12) << ec
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(9) << t_exp / te << "x" << std::scientific << std::setprecision(2)
+                  << std::setw(12) << ee << std::endl;
+    }
+
+    // the sum of main.cpp, from a table with a moderate reseed interval; its
+    // own buffers, since n may be smaller than the 10000 terms
+    const long terms = 10000;
+    std::vector<double> ts(terms), tc(terms);
+    SinCosRotation(x0, h, terms, 256, &ts[0], &tc[0]);
+    double total = 0;
+    for (long i = 0; i < terms; i++)
+        total += ts[i];
+    std::cout << std::endl << "Total " << std::fixed << std::setprecision(6) << total << std::endl;
+    return 0;
+}
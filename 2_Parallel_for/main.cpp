@@ -3,8 +3,11 @@
 #include <cassert>
 #include <iostream>
 #include <cmath>
+#include <functional>
 #include <vector>
 
+#include "transform_reduce.h"
+
 // using namespace oneapi;
 
 int main() {
@@ -14,20 +17,17 @@ int main() {
 
     auto values = std::vector<double>(10000);
 
-    oneapi::tbb::parallel_for(
-        oneapi::tbb::blocked_range<int>(0,values.size()),
-        [&](tbb::blocked_range<int> r){
-            for (int i=r.begin(); i<r.end(); i++){
-                values[i] = std::sin(i * 0.001);
-            }
-        }
+    // Fill values[i] = sin(i * 0.001) and sum them in the same parallel pass
+    // (see transform_reduce.cpp for the fill-then-sum comparison)
+    double total = TransformReduce(
+        0, (int)values.size(), 0.0,
+        [](int i){
+            return std::sin(i * 0.001);
+        },
+        std::plus<double>(),
+        &values[0]
     );
 
-    double total = 0;
-    for (double value : values){
-        total += value;
-    }
-    
     std::cout << "Total " << total << std::endl;
     return 0;
 }
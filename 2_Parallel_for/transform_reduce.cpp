@@ -0,0 +1,87 @@
+#include <oneapi/tbb/info.h>
+#include <oneapi/tbb/parallel_for.h>
+#include <oneapi/tbb/parallel_reduce.h>
+#include <oneapi/tbb/tick_count.h>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "transform_reduce.h"
+
+// Fill-then-sum versus the fused TransformReduce of transform_reduce.h.
+// g++ -O3 -march=native -std=c++17 transform_reduce.cpp -pthread -ltbb
+
+template <class F>
+double Time(int reps, F f)
+{
+    f();
+    oneapi::tbb::tick_count t0 = oneapi::tbb::tick_count::now();
+    for (int r = 0; r < reps; r++)
+        f();
+    return (oneapi::tbb::tick_count::now() - t0).seconds() / reps;
+}
+
+template <class F>
+void Compare(const std::string& name, int n, F f)
+{
+    std::vector<double> values(n);
+    int reps = std::max(3, 200000000 / (n + 1000) / 10);
+    double t1, t2, t3, t4;
+    double s1 = 0, s2 = 0, s3 = 0, s4 = 0;
+
+    // 2_Parallel_for as it was: parallel fill, serial sum
+    t1 = Time(reps, [&] {
+        oneapi::tbb::parallel_for(oneapi::tbb::blocked_range<int>(0, n),
+            [&](oneapi::tbb::blocked_range<int> r) {
+                for (int i = r.begin(); i < r.end(); i++)
+                    values[i] = f(i);
+            });
+        s1 = 0;
+        for (double v : values)
+            s1 += v;
+    });
+
+    // parallel fill, parallel sum: still two passes over values
+    t2 = Time(reps, [&] {
+        oneapi::tbb::parallel_for(oneapi::tbb::blocked_range<int>(0, n),
+            [&](oneapi::tbb::blocked_range<int> r) {
+                for (int i = r.begin(); i < r.end(); i++)
+                    values[i] = f(i);
+            });
+        s2 = oneapi::tbb::parallel_reduce(oneapi::tbb::blocked_range<int>(0, n), 0.0,
+            [&](oneapi::tbb::blocked_range<int> r, double acc) {
+                for (int i = r.begin(); i < r.end(); i++)
+                    acc += values[i];
+                return acc;
+            }, std::plus<double>());
+    });
+
+    t3 = Time(reps, [&] { s3 = TransformReduce(0, n, 0.0, f, std::plus<double>()); });
+    t4 = Time(reps, [&] { s4 = TransformReduce(0, n, 0.0, f, std::plus<double>(), &values[0]); });
+
+    std::cout << std::left << std::setw(14) << name << std::right << std::setw(10) << n
+              << std::fixed << std::setprecision(3)
+              << std::setw(12) << t1 * 1e3 << std::setw(12) << t2 * 1e3
+              << std::setw(12) << t3 * 1e3 << std::setw(12) << t4 * 1e3
+              << "   sums " << std::setprecision(6) << s1 << ' ' << s2 << ' ' << s3 << ' ' << s4
+              << std::endl;
+}
+
+int main() {
+    int num_threads = oneapi::tbb::info::default_concurrency();
+    std::cout << "Default concurrency " << num_threads << std::endl;
+    std::cout << "times in ms" << std::endl;
+    std::cout << std::left << std::setw(14) << "f(i)" << std::right << std::setw(10) << "n"
+              << std::setw(12) << "fill+serial" << std::setw(12) << "fill+reduce"
+              << std::setw(12) << "fused" << std::setw(12) << "fused+store" << std::endl;
+
+    for (int n : {10000, 1000000, 50000000}) {
+        Compare("sin(i*0.001)", n, [](int i) { return std::sin(i * 0.001); });
+        // cheap f: the memory passes dominate
+        Compare("i*0.001", n, [](int i) { return i * 0.001; });
+    }
+    return 0;
+}
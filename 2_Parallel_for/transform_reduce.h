@@ -0,0 +1,53 @@
+// Fused transform + reduce over an index range.
+//
+//     total = TransformReduce(0, n, 0.0, [](int i) { return std::sin(i * 0.001); },
+//                             std::plus<double>());
+//
+// computes f(i) and folds it into the running value inside a single
+// tbb::parallel_reduce, so nothing is written to memory. Passing an output
+// pointer as the last argument also stores every f(i) in out[i] ("also store"
+// mode) while still doing one pass instead of a parallel_for fill followed by
+// a separate sum.
+//
+// op must be associative; identity must be its neutral element.
+
+#ifndef TRANSFORM_REDUCE_H
+#define TRANSFORM_REDUCE_H
+
+#include <oneapi/tbb/blocked_range.h>
+#include <oneapi/tbb/parallel_reduce.h>
+
+template <class Index, class T, class F, class Op>
+T TransformReduce(Index first, Index last, T identity, F f, Op op)
+{
+    return oneapi::tbb::parallel_reduce(
+        oneapi::tbb::blocked_range<Index>(first, last),
+        identity,
+        [&](const oneapi::tbb::blocked_range<Index>& r, T acc) -> T {
+            for (Index i = r.begin(); i != r.end(); ++i)
+                acc = op(acc, f(i));
+            return acc;
+        },
+        op
+    );
+}
+
+template <class Index, class T, class F, class Op, class Out>
+T TransformReduce(Index first, Index last, T identity, F f, Op op, Out* out)
+{
+    return oneapi::tbb::parallel_reduce(
+        oneapi::tbb::blocked_range<Index>(first, last),
+        identity,
+        [&](const oneapi::tbb::blocked_range<Index>& r, T acc) -> T {
+            for (Index i = r.begin(); i != r.end(); ++i) {
+                auto v = f(i);
+                out[i] = v;
+                acc = op(acc, v);
+            }
+            return acc;
+        },
+        op
+    );
+}
+
+#endif
@@ -0,0 +1,183 @@
+#include <oneapi/tbb/info.h>
+#include <oneapi/tbb/parallel_for.h>
+#include <oneapi/tbb/parallel_reduce.h>
+#include <oneapi/tbb/tick_count.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "vecmath.h"
+
+// Accuracy and throughput of vecmath.h against libm.
+// g++ -O3 -march=native -std=c++17 vecmath.cpp -pthread -ltbb
+// ./a.out [n]
+
+using namespace oneapi;
+
+// error of y in units in the last place of the correctly rounded result
+double UlpError(double y, long double ref)
+{
+    double r = (double)ref;
+    if (r == 0.0)
+        return y == 0.0 ? 0.0 : INFINITY;
+    int e;
+    std::frexp(r, &e);
+    double ulp = std::ldexp(1.0, std::max(e - 53, -1074));
+    return (double)(std::fabs((long double)y - ref) / ulp);
+}
+
+struct Accuracy {
+    double max_ulp;
+    double worst_x;
+};
+
+template <class Fast, class Ref>
+Accuracy MeasureUlp(const std::vector<double>& x, Fast fast, Ref ref)
+{
+    return tbb::parallel_reduce(
+        tbb::blocked_range<size_t>(0, x.size()),
+        Accuracy{0.0, 0.0},
+        [&](const tbb::blocked_range<size_t>& r, Accuracy acc) {
+            for (size_t i = r.begin(); i < r.end(); i++) {
+                double e = UlpError(fast(x[i]), ref((long double)x[i]));
+                if (e > acc.max_ulp)
+                    acc = Accuracy{e, x[i]};
+            }
+            return acc;
+        },
+        [](Accuracy a, Accuracy b) { return a.max_ulp >= b.max_ulp ? a : b; }
+    );
+}
+
+std::vector<double> Uniform(long n, double lo, double hi, unsigned seed)
+{
+    std::vector<double> x(n);
+    std::mt19937_64 gen(seed);
+    std::uniform_real_distribution<double> u(lo, hi);
+    for (auto& v : x) v = u(gen);
+    return x;
+}
+
+// log-uniform magnitudes, exercises every exponent in [lo, hi]
+std::vector<double> LogUniform(long n, double lo, double hi, unsigned seed)
+{
+    std::vector<double> x = Uniform(n, std::log(lo), std::log(hi), seed);
+    for (auto& v : x) v = std::exp(v);
+    return x;
+}
+
+template <class Body>
+double Throughput(long n, int reps, Body body)
+{
+    body();
+    tbb::tick_count t0 = tbb::tick_count::now();
+    for (int r = 0; r < reps; r++)
+        body();
+    return n * (double)reps / (tbb::tick_count::now() - t0).seconds() * 1e-6;
+}
+
+int main(int argc, char* argv[])
+{
+    long n = argc > 1 ? atol(argv[1]) : 4000000;
+    int num_threads = oneapi::tbb::info::default_concurrency();
+    std::cout << "Default concurrency " << num_threads << std::endl << std::endl;
+
+    // ---- accuracy -------------------------------------------------------
+    struct Case {
+        std::string name;
+        std::vector<double> x;
+        std::function<double(double)> fast;
+        std::function<long double(long double)> ref;
+    };
+    std::vector<Case> cases = {
+        {"sin [-pi, pi]", Uniform(n, -M_PI, M_PI, 1), [](double v) { return vecmath::sin(v); },
+         [](long double v) { return sinl(v); }},
+        {"sin [-1e5, 1e5]", Uniform(n, -1e5, 1e5, 2), [](double v) { return vecmath::sin(v); },
+         [](long double v) { return sinl(v); }},
+        {"cos [-pi, pi]", Uniform(n, -M_PI, M_PI, 3), [](double v) { return vecmath::cos(v); },
+         [](long double v) { return cosl(v); }},
+        {"cos [-1e5, 1e5]", Uniform(n, -1e5, 1e5, 4), [](double v) { return vecmath::cos(v); },
+         [](long double v) { return cosl(v); }},
+        {"exp [-707, 709.7]", Uniform(n, -707.0, 709.7, 5), [](double v) { return vecmath::exp(v); },
+         [](long double v) { return expl(v); }},
+        {"exp [-1, 1]", Uniform(n, -1.0, 1.0, 6), [](double v) { return vecmath::exp(v); },
+         [](long double v) { return expl(v); }},
+        {"log [1e-300, 1e300]", LogUniform(n, 1e-300, 1e300, 7), [](double v) { return vecmath::log(v); },
+         [](long double v) { return logl(v); }},
+        {"log [0.5, 2]", Uniform(n, 0.5, 2.0, 8), [](double v) { return vecmath::log(v); },
+         [](long double v) { return logl(v); }},
+    };
+
+    std::cout << "Accuracy against long double libm (" << n << " samples each)" << std::endl;
+    std::cout << std::left << std::setw(22) << "function" << std::right
+              << std::setw(12) << "vecmath ulp" << std::setw(12) << "libm ulp" << std::endl;
+    for (auto& c : cases) {
+        Accuracy fast = MeasureUlp(c.x, c.fast, c.ref);
+        std::string name = c.name.substr(0, 3);
+        Accuracy libm = MeasureUlp(c.x,
+            [&](double v) {
+                return name == "sin" ? std::sin(v) : name == "cos" ? std::cos(v)
+                     : name == "exp" ? std::exp(v) : std::log(v);
+            }, c.ref);
+        std::cout << std::left << std::setw(22) << c.name << std::right << std::fixed
+                  << std::setprecision(3) << std::setw(12) << fast.max_ulp
+                  << std::setw(12) << libm.max_ulp << "   worst x " << std::setprecision(17)
+                  << std::defaultfloat << fast.worst_x << std::endl;
+    }
+
+    // ---- throughput inside parallel_for ---------------------------------
+    std::vector<double> x = Uniform(n, 0.001, 100.0, 9), y(n);
+    std::cout << std::endl << "Throughput in parallel_for (M elements/s, n = " << n << ")" << std::endl;
+    std::cout << std::left << std::setw(10) << "function" << std::right
+              << std::setw(10) << "libm" << std::setw(10) << "vecmath" << std::setw(10) << "speedup"
+              << std::endl;
+
+    auto row = [&](const std::string& name, auto libm, auto fast) {
+        double a = Throughput(n, 5, [&] {
+            tbb::parallel_for(tbb::blocked_range<long>(0, n),
+                [&](tbb::blocked_range<long> r) {
+                    for (long i = r.begin(); i < r.end(); i++)
+                        y[i] = libm(x[i]);
+                });
+        });
+        double b = Throughput(n, 5, [&] {
+            tbb::parallel_for(tbb::blocked_range<long>(0, n),
+                [&](tbb::blocked_range<long> r) {
+                    fast(&x[r.begin()], &y[r.begin()], (long)r.size());
+                });
+        });
+        std::cout << std::left << std::setw(10) << name << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(10) << a << std::setw(10) << b
+                  << std::setw(9) << b / a << "x" << std::endl;
+    };
+    row("sin", [](double v) { return std::sin(v); }, [](const double* a, double* b, long m) { vecmath::sin(a, b, m); });
+    row("cos", [](double v) { return std::cos(v); }, [](const double* a, double* b, long m) { vecmath::cos(a, b, m); });
+    row("exp", [](double v) { return std::exp(v); }, [](const double* a, double* b, long m) { vecmath::exp(a, b, m); });
+    row("log", [](double v) { return std::log(v); }, [](const double* a, double* b, long m) { vecmath::log(a, b, m); });
+
+    // ---- the sin fill from main.cpp, inline kernel in the loop body -----
+    auto values = std::vector<double>(n);
+    double a = Throughput(n, 5, [&] {
+        tbb::parallel_for(tbb::blocked_range<int>(0, values.size()),
+            [&](tbb::blocked_range<int> r) {
+                for (int i = r.begin(); i < r.end(); i++)
+                    values[i] = std::sin(i * 0.001);
+            });
+    });
+    double b = Throughput(n, 5, [&] {
+        tbb::parallel_for(tbb::blocked_range<int>(0, values.size()),
+            [&](tbb::blocked_range<int> r) {
+                for (int i = r.begin(); i < r.end(); i++)
+                    values[i] = vecmath::sin(i * 0.001);
+            });
+    });
+    std::cout << std::left << std::setw(10) << "sin fill" << std::right << std::fixed
+              << std::setprecision(1) << std::setw(10) << a << std::setw(10) << b
+              << std::setw(9) << b / a << "x" << std::endl;
+    return 0;
+}
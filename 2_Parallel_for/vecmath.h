@@ -0,0 +1,208 @@
+// Branch-free double precision sin/cos/exp/log that the compiler can
+// vectorize, so a parallel_for body such as
+//
+//     for (int i = r.begin(); i < r.end(); i++)
+//         values[i] = vecmath::sin(i * 0.001);
+//
+// runs 4 (AVX2) or 8 (AVX-512) lanes per instruction instead of one libm
+// call per element. Same idea as SLEEF / glibc libmvec: Cody-Waite range
+// reduction, a fixed polynomial and bit tricks instead of branches, so every
+// lane executes the same instructions. Build with -O3 -march=native (or at
+// least -O3 -mavx2 -mfma).
+//
+// Scalar kernels (inline, usable inside any loop) and their valid ranges:
+//
+//   sin, cos   |x| <= pi             max error 1.5 ULP  (fdlibm polynomials)
+//              |x| <= 1e5            max error 2.5 ULP  (no tail kept in the reduction)
+//   exp        -707 <= x <= 709.7    max error 1 ULP    (degree 13 Taylor)
+//   log        normal x > 0          max error 1 ULP    (fdlibm polynomial)
+//
+// libm is correctly rounded to ~0.5 ULP on all of these.
+//
+// Outside those ranges (and for NaN/Inf/subnormal inputs) the scalar kernels
+// return garbage. The array versions vecmath::sin(x, y, n) etc. run the fast
+// kernel over the whole array and then redo the out-of-range elements with
+// libm, so they are correct for every input.
+//
+// The bounds above are the ones checked by vecmath.cpp against a long double
+// reference; run it after changing a coefficient.
+
+#ifndef VECMATH_H
+#define VECMATH_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace vecmath {
+
+namespace detail {
+
+inline uint64_t Bits(double x) { uint64_t u; std::memcpy(&u, &x, 8); return u; }
+inline double FromBits(uint64_t u) { double x; std::memcpy(&x, &u, 8); return x; }
+
+// Round to nearest integer; the integer also ends up in the low mantissa bits.
+const double kRoundMagic = 0x1.8p52;
+
+// sin(r), cos(r) for |r| <= pi/4 (fdlibm __kernel_sin / __kernel_cos)
+inline double SinPoly(double r)
+{
+    const double S1 = -1.66666666666666324348e-01, S2 = 8.33333333332248946124e-03,
+                 S3 = -1.98412698298579493134e-04, S4 = 2.75573137070700676789e-06,
+                 S5 = -2.50507602534068634195e-08, S6 = 1.58969099521155010221e-10;
+    double z = r * r;
+    double p = S2 + z * (S3 + z * (S4 + z * (S5 + z * S6)));
+    return r + r * z * (S1 + z * p);
+}
+
+inline double CosPoly(double r)
+{
+    const double C1 = 4.16666666666666019037e-02, C2 = -1.38888888888741095749e-03,
+                 C3 = 2.48015872894767294178e-05, C4 = -2.75573143513906633035e-07,
+                 C5 = 2.08757232129817482790e-09, C6 = -1.13596475577881948265e-11;
+    double z = r * r;
+    double p = z * z * (C1 + z * (C2 + z * (C3 + z * (C4 + z * (C5 + z * C6)))));
+    double hz = 0.5 * z;
+    double w = 1.0 - hz;
+    return w + (((1.0 - w) - hz) + p);
+}
+
+// r = x - q*pi/2 with pi/2 split in three 33-bit pieces; low 2 bits of q
+// returned in quadrant.
+inline double ReducePio2(double x, uint64_t& quadrant)
+{
+    const double two_over_pi = 6.36619772367581382433e-01;
+    const double pio2_1 = 1.57079632673412561417e+00;
+    const double pio2_2 = 6.07710050630396597660e-11;
+    const double pio2_3 = 2.02226624871116645580e-21;
+    double t = x * two_over_pi + kRoundMagic;
+    quadrant = Bits(t);
+    double q = t - kRoundMagic;
+    return ((x - q * pio2_1) - q * pio2_2) - q * pio2_3;
+}
+
+inline double SinCosSelect(double r, uint64_t quadrant)
+{
+    double s = SinPoly(r), c = CosPoly(r);
+    double v = (quadrant & 1) ? c : s;
+    return FromBits(Bits(v) ^ ((quadrant & 2) << 62));
+}
+
+// 2^k for integral k in [-1022, 1023]
+inline double Pow2(double k)
+{
+    return FromBits(Bits(k + (kRoundMagic + 1023.0)) << 52);
+}
+
+} // namespace detail
+
+inline double sin(double x)
+{
+    uint64_t q;
+    double r = detail::ReducePio2(x, q);
+    return detail::SinCosSelect(r, q);
+}
+
+inline double cos(double x)
+{
+    uint64_t q;
+    double r = detail::ReducePio2(x, q);
+    return detail::SinCosSelect(r, q + 1);
+}
+
+inline double exp(double x)
+{
+    const double log2e = 1.44269504088896338700e+00;
+    const double ln2_hi = 6.93147180369123816490e-01;
+    const double ln2_lo = 1.90821492927058770002e-10;
+    double k = (x * log2e + detail::kRoundMagic) - detail::kRoundMagic;
+    double r = (x - k * ln2_hi) - k * ln2_lo; // |r| <= ln2/2
+    // Taylor series, remainder r^14/14! < 2^-58
+    double p = 1.0 / 6227020800.0;
+    p = p * r + 1.0 / 479001600.0;
+    p = p * r + 1.0 / 39916800.0;
+    p = p * r + 1.0 / 3628800.0;
+    p = p * r + 1.0 / 362880.0;
+    p = p * r + 1.0 / 40320.0;
+    p = p * r + 1.0 / 5040.0;
+    p = p * r + 1.0 / 720.0;
+    p = p * r + 1.0 / 120.0;
+    p = p * r + 1.0 / 24.0;
+    p = p * r + 1.0 / 6.0;
+    p = p * r + 0.5;
+    p = 1.0 + (r + r * r * p);
+    // k may be 1024 near the overflow threshold, so scale in two steps
+    return p * detail::Pow2(k - 1.0) * 2.0;
+}
+
+inline double log(double x)
+{
+    const double Lg1 = 6.666666666666735130e-01, Lg2 = 3.999999999940941908e-01,
+                 Lg3 = 2.857142874366239149e-01, Lg4 = 2.222219843214978396e-01,
+                 Lg5 = 1.818357216161805012e-01, Lg6 = 1.531383769920937332e-01,
+                 Lg7 = 1.479819860511658591e-01;
+    const double ln2_hi = 6.93147180369123816490e-01;
+    const double ln2_lo = 1.90821492927058770002e-10;
+    const double two52 = 0x1p52;
+
+    uint64_t u = detail::Bits(x);
+    // biased exponent as a double, without an int64 -> double conversion
+    double e = detail::FromBits((u >> 52) | detail::Bits(two52)) - two52 - 1023.0;
+    double m = detail::FromBits((u & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL);
+    bool big = m > 1.41421356237309504880;
+    m = big ? 0.5 * m : m;
+    e = big ? e + 1.0 : e;
+
+    double f = m - 1.0; // sqrt(2)/2 - 1 <= f <= sqrt(2) - 1
+    double s = f / (2.0 + f);
+    double z = s * s, w = z * z;
+    double t1 = w * (Lg2 + w * (Lg4 + w * Lg6));
+    double t2 = z * (Lg1 + w * (Lg3 + w * (Lg5 + w * Lg7)));
+    double R = t2 + t1;
+    double hfsq = 0.5 * f * f;
+    return e * ln2_hi - ((hfsq - (s * (hfsq + R) + e * ln2_lo)) - f);
+}
+
+// ---------------------------------------------------------------------------
+// Array versions: fast kernel for everything, libm for out-of-range inputs
+// ---------------------------------------------------------------------------
+
+inline void sin(const double x[], double y[], long n)
+{
+    for (long i = 0; i < n; i++)
+        y[i] = vecmath::sin(x[i]);
+    for (long i = 0; i < n; i++)
+        if (!(std::fabs(x[i]) <= 1e5))
+            y[i] = std::sin(x[i]);
+}
+
+inline void cos(const double x[], double y[], long n)
+{
+    for (long i = 0; i < n; i++)
+        y[i] = vecmath::cos(x[i]);
+    for (long i = 0; i < n; i++)
+        if (!(std::fabs(x[i]) <= 1e5))
+            y[i] = std::cos(x[i]);
+}
+
+inline void exp(const double x[], double y[], long n)
+{
+    for (long i = 0; i < n; i++)
+        y[i] = vecmath::exp(x[i]);
+    for (long i = 0; i < n; i++)
+        if (!(x[i] >= -707.0 && x[i] <= 709.7))
+            y[i] = std::exp(x[i]);
+}
+
+inline void log(const double x[], double y[], long n)
+{
+    for (long i = 0; i < n; i++)
+        y[i] = vecmath::log(x[i]);
+    for (long i = 0; i < n; i++)
+        if (!(x[i] >= 0x1p-1022 && x[i] <= 1.79769313486231570815e+308))
+            y[i] = std::log(x[i]);
+}
+
+} // namespace vecmath
+
+#endif
@@ -0,0 +1,382 @@
+// Sparse matrix-vector multiply (y = A*x) built from the DotProduct idea:
+// every row of A is a sparse dot product against the dense vector x.
+//
+// Formats:
+//   CSR          - row_ptr / col_idx / val
+//   SELL-C-sigma - rows sorted by length inside windows of sigma rows, packed
+//                  into chunks of C rows padded to the longest row of the chunk
+//                  and stored column-major so the C rows are processed in lock-step
+//
+// Kernels:
+//   SpMV_CSR_Rows  - parallel_for over rows (one range of rows per task)
+//   SpMV_CSR_Nnz   - nnz-balanced: every part owns the same number of nonzeros,
+//                    rows cut at a part boundary are reduced through a carry array
+//   SpMV_SELL      - parallel_for over SELL chunks
+//
+// g++ -O3 -march=native -std=c++17 spmv.cpp -pthread -ltbb
+// ./a.out [rows] [reps]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <cmath>
+
+#include <tbb/tbb.h>
+#include "oneapi/tbb/blocked_range.h"
+#include "oneapi/tbb/parallel_for.h"
+
+using namespace std;
+using namespace oneapi;
+
+struct CSRMatrix {
+    int rows = 0, cols = 0;
+    vector<int> row_ptr;   // rows+1
+    vector<int> col_idx;   // nnz
+    vector<double> val;    // nnz
+
+    long nnz() const { return row_ptr.empty() ? 0 : row_ptr[rows]; }
+};
+
+struct SELLMatrix {
+    int rows = 0, C = 0, sigma = 0;
+    vector<int> perm;       // perm[k] = original row stored at sorted position k
+    vector<long> chunk_ptr; // start of every chunk in col_idx/val
+    vector<int> chunk_len;  // padded row length of every chunk
+    vector<int> col_idx;    // padding entries point to column 0 with value 0
+    vector<double> val;
+
+    int chunks() const { return (int)chunk_len.size(); }
+};
+
+// ---------------------------------------------------------------------------
+// Matrix generators
+// ---------------------------------------------------------------------------
+
+CSRMatrix BuildFromLengths(const vector<int>& len, int cols, unsigned seed)
+{
+    CSRMatrix A;
+    A.rows = len.size();
+    A.cols = cols;
+    A.row_ptr.assign(A.rows + 1, 0);
+    for (int i = 0; i < A.rows; i++)
+        A.row_ptr[i + 1] = A.row_ptr[i] + len[i];
+    A.col_idx.resize(A.nnz());
+    A.val.resize(A.nnz());
+
+    tbb::parallel_for(
+        tbb::blocked_range<int>(0, A.rows),
+        [&](tbb::blocked_range<int> r) {
+            mt19937 gen(seed + r.begin());
+            uniform_int_distribution<int> col(0, cols - 1);
+            uniform_real_distribution<double> v(-1.0, 1.0);
+            for (int i = r.begin(); i < r.end(); i++) {
+                int* c = &A.col_idx[A.row_ptr[i]];
+                int n = len[i];
+                for (int k = 0; k < n; k++)
+                    c[k] = col(gen);
+                sort(c, c + n);
+                for (int k = 0; k < n; k++)
+                    A.val[A.row_ptr[i] + k] = v(gen);
+            }
+        }
+    );
+    return A;
+}
+
+// Row lengths follow a discrete Pareto law: most rows are short, a few rows
+// hold a large share of the nonzeros (web / social graphs).
+CSRMatrix PowerLawMatrix(int n, double avg_nnz, double alpha, unsigned seed)
+{
+    mt19937 gen(seed);
+    uniform_real_distribution<double> u(0.0, 1.0);
+    double xm = avg_nnz * (alpha - 1.0) / alpha;
+    vector<int> len(n);
+    for (int i = 0; i < n; i++) {
+        double l = xm / pow(1.0 - u(gen), 1.0 / alpha);
+        len[i] = (int)min<double>(max(1.0, l), n);
+    }
+    return BuildFromLengths(len, n, seed);
+}
+
+// Banded matrix: row i has nonzeros in columns [i-b, i+b].
+CSRMatrix BandedMatrix(int n, int b)
+{
+    CSRMatrix A;
+    A.rows = A.cols = n;
+    A.row_ptr.assign(n + 1, 0);
+    for (int i = 0; i < n; i++)
+        A.row_ptr[i + 1] = A.row_ptr[i] + (min(n - 1, i + b) - max(0, i - b) + 1);
+    A.col_idx.resize(A.nnz());
+    A.val.resize(A.nnz());
+
+    tbb::parallel_for(
+        tbb::blocked_range<int>(0, n),
+        [&](tbb::blocked_range<int> r) {
+            for (int i = r.begin(); i < r.end(); i++) {
+                int k = A.row_ptr[i];
+                for (int j = max(0, i - b); j <= min(n - 1, i + b); j++, k++) {
+                    A.col_idx[k] = j;
+                    A.val[k] = (i == j) ? 2.0 : -1.0 / (1 + abs(i - j));
+                }
+            }
+        }
+    );
+    return A;
+}
+
+// ---------------------------------------------------------------------------
+// Conversion CSR -> SELL-C-sigma
+// ---------------------------------------------------------------------------
+
+SELLMatrix ToSELL(const CSRMatrix& A, int C, int sigma)
+{
+    SELLMatrix S;
+    S.rows = A.rows;
+    S.C = C;
+    S.sigma = sigma;
+    S.perm.resize(A.rows);
+    iota(S.perm.begin(), S.perm.end(), 0);
+
+    auto len = [&](int i) { return A.row_ptr[i + 1] - A.row_ptr[i]; };
+
+    // sort by descending length inside every sigma window
+    tbb::parallel_for(
+        tbb::blocked_range<int>(0, (A.rows + sigma - 1) / sigma),
+        [&](tbb::blocked_range<int> r) {
+            for (int w = r.begin(); w < r.end(); w++) {
+                auto first = S.perm.begin() + (long)w * sigma;
+                auto last = S.perm.begin() + min<long>((long)(w + 1) * sigma, A.rows);
+                stable_sort(first, last, [&](int a, int b) { return len(a) > len(b); });
+            }
+        }
+    );
+
+    int nchunks = (A.rows + C - 1) / C;
+    S.chunk_len.resize(nchunks);
+    S.chunk_ptr.assign(nchunks + 1, 0);
+    for (int c = 0; c < nchunks; c++) {
+        int l = 0;
+        for (int k = c * C; k < min(A.rows, (c + 1) * C); k++)
+            l = max(l, len(S.perm[k]));
+        S.chunk_len[c] = l;
+        S.chunk_ptr[c + 1] = S.chunk_ptr[c] + (long)l * C;
+    }
+    S.col_idx.assign(S.chunk_ptr[nchunks], 0);
+    S.val.assign(S.chunk_ptr[nchunks], 0.0);
+
+    tbb::parallel_for(
+        tbb::blocked_range<int>(0, nchunks),
+        [&](tbb::blocked_range<int> r) {
+            for (int c = r.begin(); c < r.end(); c++) {
+                for (int lane = 0; lane < C && c * C + lane < A.rows; lane++) {
+                    int row = S.perm[c * C + lane];
+                    for (int k = A.row_ptr[row]; k < A.row_ptr[row + 1]; k++) {
+                        long dst = S.chunk_ptr[c] + (long)(k - A.row_ptr[row]) * C + lane;
+                        S.col_idx[dst] = A.col_idx[k];
+                        S.val[dst] = A.val[k];
+                    }
+                }
+            }
+        }
+    );
+    return S;
+}
+
+// ---------------------------------------------------------------------------
+// Kernels
+// ---------------------------------------------------------------------------
+
+void SpMV_Serial(const CSRMatrix& A, const double x[], double y[])
+{
+    for (int i = 0; i < A.rows; i++) {
+        double acc = 0.0;
+        for (int k = A.row_ptr[i]; k < A.row_ptr[i + 1]; k++)
+            acc += A.val[k] * x[A.col_idx[k]];
+        y[i] = acc;
+    }
+}
+
+void SpMV_CSR_Rows(const CSRMatrix& A, const double x[], double y[])
+{
+    tbb::parallel_for(
+        tbb::blocked_range<int>(0, A.rows),
+        [&](tbb::blocked_range<int> r) {
+            for (int i = r.begin(); i < r.end(); i++) {
+                double acc = 0.0;
+                for (int k = A.row_ptr[i]; k < A.row_ptr[i + 1]; k++)
+                    acc += A.val[k] * x[A.col_idx[k]];
+                y[i] = acc;
+            }
+        }
+    );
+}
+
+// Static nnz-balanced partition: part p owns nonzeros [p*nnz/P, (p+1)*nnz/P).
+// A row that spans several parts is summed piecewise: the part where the row
+// starts writes y[row], every later piece goes to carry[p] and is added
+// afterwards (P values, so the fix-up is serial and cheap).
+struct NnzPartition {
+    int parts = 0;
+    vector<long> nz_begin;   // parts+1
+    vector<int> row_begin;   // row holding nonzero nz_begin[p] (rows for the end)
+};
+
+NnzPartition PartitionByNnz(const CSRMatrix& A, int parts)
+{
+    NnzPartition P;
+    P.parts = parts;
+    P.nz_begin.resize(parts + 1);
+    P.row_begin.resize(parts + 1);
+    long nnz = A.nnz();
+    for (int p = 0; p <= parts; p++) {
+        long nz = nnz * p / parts;
+        // first row i with row_ptr[i+1] > nz; empty rows before it go to part p-1
+        P.nz_begin[p] = nz;
+        P.row_begin[p] = upper_bound(A.row_ptr.begin() + 1, A.row_ptr.end(), nz)
+                         - (A.row_ptr.begin() + 1);
+    }
+    P.row_begin[0] = 0;
+    return P;
+}
+
+void SpMV_CSR_Nnz(const CSRMatrix& A, const NnzPartition& P, const double x[], double y[])
+{
+    vector<double> carry(P.parts, 0.0);
+    vector<int> carry_row(P.parts, -1);
+
+    tbb::parallel_for(
+        tbb::blocked_range<int>(0, P.parts, 1),
+        [&](tbb::blocked_range<int> r) {
+            for (int p = r.begin(); p < r.end(); p++) {
+                long nz = P.nz_begin[p], nz_end = P.nz_begin[p + 1];
+                int last = min(P.row_begin[p + 1], A.rows - 1);
+                for (int i = P.row_begin[p]; i <= last; i++) {
+                    if (i == P.row_begin[p + 1] && A.row_ptr[i] >= nz_end)
+                        break; // row starts in the next part
+                    long lo = max<long>(A.row_ptr[i], nz);
+                    long hi = min<long>(A.row_ptr[i + 1], nz_end);
+                    double acc = 0.0;
+                    for (long k = lo; k < hi; k++)
+                        acc += A.val[k] * x[A.col_idx[k]];
+                    if (A.row_ptr[i] < nz) {
+                        carry[p] = acc;
+                        carry_row[p] = i;
+                    } else {
+                        y[i] = acc;
+                    }
+                }
+            }
+        }
+    );
+
+    for (int p = 0; p < P.parts; p++)
+        if (carry_row[p] >= 0)
+            y[carry_row[p]] += carry[p];
+}
+
+void SpMV_SELL(const SELLMatrix& S, const double x[], double y[])
+{
+    const int C = S.C;
+    tbb::parallel_for(
+        tbb::blocked_range<int>(0, S.chunks()),
+        [&](tbb::blocked_range<int> r) {
+            vector<double> acc(C);
+            for (int c = r.begin(); c < r.end(); c++) {
+                fill(acc.begin(), acc.end(), 0.0);
+                const int* col = &S.col_idx[S.chunk_ptr[c]];
+                const double* v = &S.val[S.chunk_ptr[c]];
+                for (int j = 0; j < S.chunk_len[c]; j++) {
+                    for (int lane = 0; lane < C; lane++)
+                        acc[lane] += v[lane] * x[col[lane]];
+                    col += C;
+                    v += C;
+                }
+                for (int lane = 0; lane < C && c * C + lane < S.rows; lane++)
+                    y[S.perm[c * C + lane]] = acc[lane];
+            }
+        }
+    );
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark
+// ---------------------------------------------------------------------------
+
+double MaxError(const vector<double>& a, const vector<double>& b)
+{
+    double e = 0.0;
+    for (size_t i = 0; i < a.size(); i++)
+        e = max(e, abs(a[i] - b[i]) / max(1.0, abs(b[i])));
+    return e;
+}
+
+template <class F>
+void Report(const string& name, const CSRMatrix& A, int reps, const vector<double>& ref,
+            vector<double>& y, F kernel)
+{
+    kernel(); // warm-up
+    tbb::tick_count t0 = tbb::tick_count::now();
+    for (int r = 0; r < reps; r++)
+        kernel();
+    double t = (tbb::tick_count::now() - t0).seconds() / reps;
+    cout << "  " << left << setw(22) << name << right
+         << setw(10) << fixed << setprecision(3) << t * 1e3 << " ms"
+         << setw(9) << setprecision(2) << 2.0 * A.nnz() / t * 1e-9 << " GFLOP/s"
+         << "   err " << scientific << setprecision(1) << MaxError(y, ref) << endl;
+    cout << defaultfloat;
+}
+
+void Benchmark(const string& title, const CSRMatrix& A, int reps)
+{
+    long min_len = A.rows, max_len = 0;
+    for (int i = 0; i < A.rows; i++) {
+        long l = A.row_ptr[i + 1] - A.row_ptr[i];
+        min_len = min(min_len, l);
+        max_len = max(max_len, l);
+    }
+    cout << title << ": rows " << A.rows << ", nnz " << A.nnz()
+         << ", row length [" << min_len << ", " << max_len << "]" << endl;
+
+    vector<double> x(A.cols), ref(A.rows), y(A.rows);
+    mt19937 gen(7);
+    uniform_real_distribution<double> u(-1.0, 1.0);
+    for (auto& v : x) v = u(gen);
+    SpMV_Serial(A, &x[0], &ref[0]);
+
+    int threads = tbb::info::default_concurrency();
+    NnzPartition P = PartitionByNnz(A, 8 * threads);
+    SELLMatrix S = ToSELL(A, 8, 256);
+    double fill = (double)S.val.size() / max(1L, A.nnz());
+
+    Report("serial CSR", A, reps, ref, y, [&] { SpMV_Serial(A, &x[0], &y[0]); });
+    Report("CSR row-partitioned", A, reps, ref, y, [&] { SpMV_CSR_Rows(A, &x[0], &y[0]); });
+    Report("CSR nnz-balanced", A, reps, ref, y, [&] { SpMV_CSR_Nnz(A, P, &x[0], &y[0]); });
+    Report("SELL-8-256", A, reps, ref, y, [&] { SpMV_SELL(S, &x[0], &y[0]); });
+    cout << "  SELL padding overhead " << fixed << setprecision(2) << fill << "x" << endl << defaultfloat;
+}
+
+int main(int argc, char* argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : 200000;
+    int reps = argc > 2 ? atoi(argv[2]) : 10;
+
+    cout << "Default concurrency " << tbb::info::default_concurrency() << endl;
+
+    // Tiny example in the spirit of DotProduct: [[1 0 2] [0 3 0] [4 0 5]] * [1 2 3]
+    CSRMatrix T;
+    T.rows = T.cols = 3;
+    T.row_ptr = {0, 2, 3, 5};
+    T.col_idx = {0, 2, 1, 0, 2};
+    T.val = {1., 2., 3., 4., 5.};
+    vector<double> tx{1., 2., 3.}, ty(3);
+    SpMV_CSR_Nnz(T, PartitionByNnz(T, 2), &tx[0], &ty[0]);
+    cout << "Small SpMV: " << ty[0] << ' ' << ty[1] << ' ' << ty[2] << endl << endl;
+
+    Benchmark("Power-law", PowerLawMatrix(n, 16.0, 1.5, 42), reps);
+    Benchmark("Banded (b=8)", BandedMatrix(n, 8), reps);
+
+    return 0;
+}
@@ -0,0 +1,327 @@
+// One-dimensional bin packing: n items with integer sizes in [1, C] go into
+// as few bins of capacity C as possible.
+//
+// Front end: the items are sorted by decreasing size with tbb::parallel_sort
+// and a lower bound is computed from a parallel size histogram.
+//
+// Heuristics, all run concurrently in one task_group (best result wins):
+//
+//   FF        first fit in input order (online, no sort)
+//   FFD       first fit decreasing. The bins are the leaves of a max segment
+//             tree over their remaining capacity, so "leftmost bin that
+//             still fits" is one O(log bins) descent instead of a linear scan.
+//             Unopened bins are leaves with remaining capacity C, so the
+//             descent opens a new bin by itself when no open bin fits.
+//   BFD       best fit decreasing. Bins are kept in buckets by remaining
+//             capacity; the tightest fit is the first non-empty bucket >= size,
+//             found in a bitset of non-empty buckets.
+//   NFD       next fit decreasing, only one open bin
+//   FFD/S     FFD on S stripes: sorted item k goes to stripe k mod S, every
+//             stripe is packed independently in a parallel_for. Scales with
+//             the cores at the cost of at most a few bins per stripe.
+//
+// Lower bound: the larger of L1 = ceil(sum / C) and the Martello-Toth L2 over
+// every threshold alpha <= C/2. gap = bins / bound - 1, an upper bound on how
+// far the result is from optimal.
+//
+// g++ -O3 -march=native -std=c++17 binpacking.cpp -pthread -ltbb
+// ./a.out [n] [stripes]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <string>
+#include <cstdint>
+
+#include <tbb/tbb.h>
+#include "oneapi/tbb/blocked_range.h"
+#include "oneapi/tbb/parallel_for.h"
+#include "oneapi/tbb/parallel_reduce.h"
+#include "oneapi/tbb/parallel_sort.h"
+#include "oneapi/tbb/task_group.h"
+#include "oneapi/tbb/enumerable_thread_specific.h"
+
+using namespace std;
+using namespace oneapi;
+
+const int C = 10000;   // bin capacity
+
+// bin[i] = bin of item i, bins = number of bins used
+struct Packing {
+    string name;
+    vector<int> bin;
+    int bins = 0;
+    double seconds = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Heuristics (items given in the order they are packed)
+// ---------------------------------------------------------------------------
+
+// max segment tree over the remaining capacity of `leaves` bins
+struct FitTree {
+    int size;
+    vector<int> t;
+
+    FitTree(int leaves) {
+        size = 1;
+        while (size < leaves)
+            size *= 2;
+        t.assign(2 * size, C);
+    }
+    // leftmost bin with remaining capacity >= s
+    int find(int s) const {
+        int v = 1;
+        while (v < size)
+            v = t[2 * v] >= s ? 2 * v : 2 * v + 1;
+        return v - size;
+    }
+    void take(int b, int s) {
+        int v = b + size;
+        t[v] -= s;
+        for (v /= 2; v >= 1; v /= 2)
+            t[v] = max(t[2 * v], t[2 * v + 1]);
+    }
+};
+
+// first fit can not use more than 2 * ceil(sum / C) bins: two consecutive
+// bins always hold more than C
+int MaxBins(const int size[], long n)
+{
+    long sum = 0;
+    for (long i = 0; i < n; i++)
+        sum += size[i];
+    return (int)min<long>(n, 2 * ((sum + C - 1) / C) + 1);
+}
+
+int FirstFit(const int size[], long n, int bin[])
+{
+    FitTree tree(max(1, MaxBins(size, n)));
+    int bins = 0;
+    for (long i = 0; i < n; i++) {
+        int b = tree.find(size[i]);
+        tree.take(b, size[i]);
+        bin[i] = b;
+        bins = max(bins, b + 1);
+    }
+    return bins;
+}
+
+int BestFit(const int size[], long n, int bin[])
+{
+    vector<vector<int>> bucket(C + 1);             // bins by remaining capacity
+    vector<uint64_t> nonempty((C + 1 + 63) / 64, 0);
+    int bins = 0;
+    for (long i = 0; i < n; i++) {
+        int s = size[i];
+        int r = -1;
+        for (size_t w = s / 64; w < nonempty.size(); w++) {
+            uint64_t bits = nonempty[w] & (w == (size_t)s / 64 ? ~0ULL << (s % 64) : ~0ULL);
+            if (bits) {
+                r = 64 * w + __builtin_ctzll(bits);
+                break;
+            }
+        }
+        int b;
+        if (r < 0) {
+            b = bins++;
+            r = C;
+        } else {
+            b = bucket[r].back();
+            bucket[r].pop_back();
+            if (bucket[r].empty())
+                nonempty[r / 64] &= ~(1ULL << (r % 64));
+        }
+        bin[i] = b;
+        r -= s;
+        bucket[r].push_back(b);
+        nonempty[r / 64] |= 1ULL << (r % 64);
+    }
+    return bins;
+}
+
+int NextFit(const int size[], long n, int bin[])
+{
+    int bins = 0, room = 0;
+    for (long i = 0; i < n; i++) {
+        if (size[i] > room) {
+            bins++;
+            room = C;
+        }
+        room -= size[i];
+        bin[i] = bins - 1;
+    }
+    return bins;
+}
+
+int StripedFirstFit(const int size[], long n, int bin[], int stripes)
+{
+    vector<int> stripe_bins(stripes + 1, 0);
+    tbb::parallel_for(
+        tbb::blocked_range<int>(0, stripes, 1),
+        [&](tbb::blocked_range<int> r) {
+            for (int s = r.begin(); s < r.end(); s++) {
+                long m = n > s ? (n - s + stripes - 1) / stripes : 0;
+                vector<int> sz(m), b(m);
+                for (long k = 0; k < m; k++)
+                    sz[k] = size[s + k * stripes];
+                stripe_bins[s + 1] = FirstFit(sz.data(), m, b.data());
+                for (long k = 0; k < m; k++)
+                    bin[s + k * stripes] = b[k];
+            }
+        }
+    );
+    for (int s = 0; s < stripes; s++)
+        stripe_bins[s + 1] += stripe_bins[s];
+    tbb::parallel_for(
+        tbb::blocked_range<long>(0, n),
+        [&](tbb::blocked_range<long> r) {
+            for (long i = r.begin(); i < r.end(); i++)
+                bin[i] += stripe_bins[i % stripes];
+        }
+    );
+    return stripe_bins[stripes];
+}
+
+// ---------------------------------------------------------------------------
+// Lower bound and check
+// ---------------------------------------------------------------------------
+
+vector<long> SizeHistogram(const vector<int>& size)
+{
+    tbb::enumerable_thread_specific<vector<long>> local([] { return vector<long>(C + 1, 0); });
+    tbb::parallel_for(
+        tbb::blocked_range<long>(0, size.size()),
+        [&](tbb::blocked_range<long> r) {
+            vector<long>& h = local.local();
+            for (long i = r.begin(); i < r.end(); i++)
+                h[size[i]]++;
+        }
+    );
+    vector<long> hist(C + 1, 0);
+    for (const vector<long>& h : local)
+        for (int s = 0; s <= C; s++)
+            hist[s] += h[s];
+    return hist;
+}
+
+// max(L1, L2): for alpha <= C/2, items > C - alpha need a bin each, items in
+// (C/2, C - alpha] too and they leave |J2| C - sum(J2) space for the items in
+// [alpha, C/2], the rest of which needs further bins
+long LowerBound(const vector<long>& hist)
+{
+    vector<long> cnt(C + 2, 0), sum(C + 2, 0);   // over sizes >= s
+    for (int s = C; s >= 1; s--) {
+        cnt[s] = cnt[s + 1] + hist[s];
+        sum[s] = sum[s + 1] + hist[s] * s;
+    }
+    long bound = (sum[1] + C - 1) / C;
+    for (int alpha = 1; alpha <= C / 2; alpha++) {
+        long j1 = cnt[C - alpha + 1];
+        long j2 = cnt[C / 2 + 1] - j1;
+        long s2 = sum[C / 2 + 1] - sum[C - alpha + 1];
+        long s3 = sum[alpha] - sum[C / 2 + 1];
+        long rest = s3 - (j2 * C - s2);
+        bound = max(bound, j1 + j2 + max(0L, (rest + C - 1) / C));
+    }
+    return bound;
+}
+
+bool Valid(const vector<int>& size, const Packing& p)
+{
+    vector<long> load(p.bins, 0);
+    for (size_t i = 0; i < size.size(); i++) {
+        if (p.bin[i] < 0 || p.bin[i] >= p.bins)
+            return false;
+        load[p.bin[i]] += size[i];
+    }
+    return all_of(load.begin(), load.end(), [](long l) { return l <= C; });
+}
+
+// ---------------------------------------------------------------------------
+
+void Solve(const string& name, const vector<int>& items, int stripes)
+{
+    long n = items.size();
+    cout << name << ", n = " << n << ", C = " << C << endl;
+
+    tbb::tick_count t0 = tbb::tick_count::now();
+    vector<int> sorted = items;
+    tbb::parallel_sort(sorted.begin(), sorted.end(), greater<int>());
+    double t_sort = (tbb::tick_count::now() - t0).seconds();
+
+    t0 = tbb::tick_count::now();
+    long bound = LowerBound(SizeHistogram(items));
+    double t_bound = (tbb::tick_count::now() - t0).seconds();
+
+    vector<Packing> res(5);
+    const char* names[5] = {"FF", "FFD", "BFD", "NFD", "FFD/S"};
+    for (int v = 0; v < 5; v++) {
+        res[v].name = names[v];
+        res[v].bin.resize(n);
+    }
+    res[4].name += to_string(stripes);
+
+    t0 = tbb::tick_count::now();
+    tbb::task_group g;
+    auto run = [&](int v, function<int(const int*, int*)> heuristic, const int* in) {
+        g.run([&res, v, heuristic, in] {
+            tbb::tick_count s0 = tbb::tick_count::now();
+            res[v].bins = heuristic(in, &res[v].bin[0]);
+            res[v].seconds = (tbb::tick_count::now() - s0).seconds();
+        });
+    };
+    run(0, [n](const int* s, int* b) { return FirstFit(s, n, b); }, &items[0]);
+    run(1, [n](const int* s, int* b) { return FirstFit(s, n, b); }, &sorted[0]);
+    run(2, [n](const int* s, int* b) { return BestFit(s, n, b); }, &sorted[0]);
+    run(3, [n](const int* s, int* b) { return NextFit(s, n, b); }, &sorted[0]);
+    run(4, [n, stripes](const int* s, int* b) { return StripedFirstFit(s, n, b, stripes); }, &sorted[0]);
+    g.wait();
+    double t_all = (tbb::tick_count::now() - t0).seconds();
+
+    int best = 0;
+    for (int v = 1; v < 5; v++)
+        if (res[v].bins < res[best].bins)
+            best = v;
+
+    cout << "  sort " << fixed << setprecision(1) << t_sort * 1e3 << " ms, lower bound "
+         << bound << " in " << t_bound * 1e3 << " ms" << endl;
+    cout << "  " << left << setw(10) << "heuristic" << right << setw(12) << "bins"
+         << setw(10) << "gap" << setw(10) << "ms" << setw(14) << "10^6 items/s" << endl;
+    for (int v = 0; v < 5; v++) {
+        bool ok = v == 0 ? Valid(items, res[v]) : Valid(sorted, res[v]);
+        cout << "  " << left << setw(10) << res[v].name << right << setw(12) << res[v].bins
+             << setw(9) << setprecision(3) << 100.0 * (res[v].bins - bound) / bound << "%"
+             << setw(10) << setprecision(1) << res[v].seconds * 1e3
+             << setw(14) << n / res[v].seconds * 1e-6
+             << (ok ? "" : "   INVALID") << (v == best ? "   <- best" : "") << endl;
+    }
+    cout << "  all heuristics concurrently " << setprecision(1) << t_all * 1e3 << " ms, end to end "
+         << n / (t_sort + t_all) * 1e-6 << " 10^6 items/s" << endl << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    long n = argc > 1 ? atol(argv[1]) : 10000000;
+    int stripes = argc > 2 ? atoi(argv[2]) : 8;
+    cout << "Default concurrency " << tbb::info::default_concurrency() << endl << endl;
+
+    mt19937 gen(7);
+    vector<int> items(n);
+
+    uniform_int_distribution<int> any(1, C);
+    for (auto& s : items) s = any(gen);
+    Solve("uniform [1, C]", items, stripes);
+
+    uniform_int_distribution<int> mid(C / 5, C / 2);
+    for (auto& s : items) s = mid(gen);
+    Solve("uniform [C/5, C/2]", items, stripes);
+
+    uniform_int_distribution<int> small(1, C / 10);
+    for (auto& s : items) s = small(gen);
+    Solve("uniform [1, C/10]", items, stripes);
+    return 0;
+}
@@ -0,0 +1,244 @@
+// k-way partition: doMAP's x[i] >= a generalised from 2 outputs to k. Every
+// element goes to bucket f(x) in [0, k), buckets are contiguous in the output
+// and keep the input order (the partition step of a radix hash join or a
+// shuffle):
+//
+//   count    every chunk histograms f(x) into its column of a k x chunks
+//            matrix, stored bucket-major: count[b * chunks + c]
+//   prefix   one pass over the matrix in that order gives every (bucket,
+//            chunk) pair its first output position
+//   scatter  every chunk walks its elements again and writes each one to
+//            out[pos[f(x)]++]
+//
+// f is evaluated in both passes instead of keeping it in a side array. With
+// many buckets every element of the scatter goes to a different place; the
+// "combined" variant gathers one cache line per bucket in a thread-local
+// buffer and copies full lines (as radix_sort.h in 12_Example_Sorting).
+//
+// The benchmark partitions 8-byte (key, payload) tuples by a multiplicative
+// hash of the key and by range boundaries (search tree), for k = 2 .. 4096,
+// and compares the output with a serial counting partition.
+//
+// g++ -O3 -march=native -std=c++17 kway_partition.cpp -pthread -ltbb
+// ./a.out [n]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <cstdint>
+#include <cstring>
+
+#include <tbb/tbb.h>
+#include "oneapi/tbb/blocked_range.h"
+#include "oneapi/tbb/parallel_for.h"
+#include "oneapi/tbb/enumerable_thread_specific.h"
+
+using namespace std;
+using namespace oneapi;
+
+struct Tuple {
+    uint32_t key;
+    uint32_t payload;
+};
+
+bool operator==(const Tuple& a, const Tuple& b) { return a.key == b.key && a.payload == b.payload; }
+
+// thread-local line per bucket for the combined scatter
+template <class T>
+struct Lines {
+    static const int L = 64 / sizeof(T);
+    vector<T> line;
+    vector<unsigned char> fill;
+};
+
+// bucket b holds the keys in [bound[b-1], bound[b]). The sorted bounds are
+// padded to 2^levels - 1 and laid out as an implicit search tree (children of
+// node j at 2j, 2j + 1), so a lookup is levels steps without a branch.
+struct Ranges {
+    int levels = 0, k;
+    vector<uint32_t> tree;
+
+    explicit Ranges(const vector<uint32_t>& bound) : k(bound.size() + 1) {
+        while ((1 << levels) < k)
+            levels++;
+        vector<uint32_t> padded(bound);
+        padded.resize((1 << levels) - 1, UINT32_MAX);
+        tree.resize(1 << levels);
+        Build(padded, 1, 0, padded.size());
+    }
+    void Build(const vector<uint32_t>& s, int node, int lo, int hi) {
+        if (lo >= hi)
+            return;
+        int mid = (lo + hi) / 2;
+        tree[node] = s[mid];
+        Build(s, 2 * node, lo, mid);
+        Build(s, 2 * node + 1, mid + 1, hi);
+    }
+    int Find(uint32_t key) const {
+        int j = 1;
+        for (int l = 0; l < levels; l++)
+            j = 2 * j + (tree[j] <= key);
+        return min(j - (1 << levels), k - 1);   // padding catches UINT32_MAX
+    }
+};
+
+// elements per chunk: large against k so the matrix stays small
+long ChunkSize(int k) { return max(1L << 16, 64L * k); }
+
+// partitions x[0, n) into out, returns the k + 1 bucket boundaries
+template <class T, class F>
+vector<long> Partition(const T* x, long n, int k, F bucket_of, T* out, bool combine)
+{
+    const long chunk = ChunkSize(k), chunks = (n + chunk - 1) / chunk;
+    vector<long> count((long)k * chunks);
+    tbb::parallel_for(
+        tbb::blocked_range<long>(0, chunks),
+        [&](tbb::blocked_range<long> r) {
+            vector<long> h(k);
+            for (long c = r.begin(); c < r.end(); c++) {
+                fill(h.begin(), h.end(), 0);
+                for (long i = c * chunk; i < min(n, (c + 1) * chunk); i++)
+                    h[bucket_of(x[i])]++;
+                for (int b = 0; b < k; b++)
+                    count[b * chunks + c] = h[b];
+            }
+        }
+    );
+
+    vector<long> bucket_begin(k + 1);
+    long pos = 0;
+    for (int b = 0; b < k; b++) {
+        bucket_begin[b] = pos;
+        for (long c = 0; c < chunks; c++) {
+            long v = count[b * chunks + c];
+            count[b * chunks + c] = pos;
+            pos += v;
+        }
+    }
+    bucket_begin[k] = n;
+
+    tbb::enumerable_thread_specific<Lines<T>> lines;
+    const int L = Lines<T>::L;
+    tbb::parallel_for(
+        tbb::blocked_range<long>(0, chunks),
+        [&](tbb::blocked_range<long> r) {
+            vector<long> dst(k);
+            Lines<T>& buf = lines.local();
+            if (combine && (int)buf.fill.size() != k) {
+                buf.line.resize((long)k * L);
+                buf.fill.assign(k, 0);
+            }
+            for (long c = r.begin(); c < r.end(); c++) {
+                for (int b = 0; b < k; b++)
+                    dst[b] = count[b * chunks + c];
+                long lo = c * chunk, hi = min(n, lo + chunk);
+                if (!combine) {
+                    for (long i = lo; i < hi; i++)
+                        out[dst[bucket_of(x[i])]++] = x[i];
+                    continue;
+                }
+                for (long i = lo; i < hi; i++) {
+                    int b = bucket_of(x[i]);
+                    int f = buf.fill[b];
+                    buf.line[b * L + f] = x[i];
+                    if (++f == L) {
+                        memcpy(out + dst[b], &buf.line[b * L], sizeof(T) * L);
+                        dst[b] += L;
+                        f = 0;
+                    }
+                    buf.fill[b] = f;
+                }
+                for (int b = 0; b < k; b++) {
+                    memcpy(out + dst[b], &buf.line[b * L], sizeof(T) * buf.fill[b]);
+                    buf.fill[b] = 0;
+                }
+            }
+        }
+    );
+    return bucket_begin;
+}
+
+// ---------------------------------------------------------------------------
+
+template <class T, class F>
+vector<T> PartitionSerial(const vector<T>& x, int k, F bucket_of)
+{
+    vector<long> pos(k + 1, 0);
+    for (const T& e : x)
+        pos[bucket_of(e) + 1]++;
+    for (int b = 0; b < k; b++)
+        pos[b + 1] += pos[b];
+    vector<T> out(x.size());
+    for (const T& e : x)
+        out[pos[bucket_of(e)]++] = e;
+    return out;
+}
+
+template <class F>
+double Time(int reps, F f)
+{
+    f();
+    tbb::tick_count t0 = tbb::tick_count::now();
+    for (int r = 0; r < reps; r++)
+        f();
+    return (tbb::tick_count::now() - t0).seconds() / reps;
+}
+
+template <class F>
+void Evaluate(const string& name, const vector<Tuple>& x, int k, F bucket_of)
+{
+    long n = x.size();
+    vector<Tuple> out(n), out_wc(n);
+    vector<long> begin;
+    double t = Time(3, [&] { begin = Partition(x.data(), n, k, bucket_of, out.data(), false); });
+    double t_wc = Time(3, [&] { Partition(x.data(), n, k, bucket_of, out_wc.data(), true); });
+
+    vector<Tuple> ref = PartitionSerial(x, k, bucket_of);
+    long largest = 0;
+    for (int b = 0; b < k; b++)
+        largest = max(largest, begin[b + 1] - begin[b]);
+    bool ok = out == ref && out_wc == ref;
+    cout << setw(8) << name << setw(8) << k << setw(12) << largest << fixed << setprecision(1)
+         << setw(12) << n / t * 1e-6 << setw(12) << n / t_wc * 1e-6 << setw(10)
+         << setprecision(2) << t / t_wc << "x" << (ok ? "" : "   MISMATCH") << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    long n = argc > 1 ? atol(argv[1]) : 1 << 24;
+    if (n <= 0) {
+        cerr << "n must be positive" << endl;
+        return 1;
+    }
+    cout << "Default concurrency " << tbb::info::default_concurrency() << endl;
+
+    mt19937 gen(9);
+    vector<Tuple> x(n);
+    for (long i = 0; i < n; i++)
+        x[i] = Tuple{(uint32_t)gen(), (uint32_t)i};
+
+    cout << "n = " << n << " tuples, 10^6 tuples/s" << endl;
+    cout << setw(8) << "f" << setw(8) << "k" << setw(12) << "largest" << setw(12) << "direct"
+         << setw(12) << "combined" << setw(11) << "speedup" << endl;
+    for (int logk = 1; logk <= 12; logk++) {
+        int k = 1 << logk;
+        Evaluate("hash", x, k, [logk](const Tuple& t) {
+            return (int)((t.key * 2654435761u) >> (32 - logk));
+        });
+    }
+    for (int k : {2, 3, 10, 100, 1000, 4096}) {
+        // boundaries from a sample, so the ranges hold about n / k keys each
+        vector<uint32_t> sample(64 * k);
+        for (auto& s : sample) s = x[gen() % n].key;
+        sort(sample.begin(), sample.end());
+        vector<uint32_t> bound(k - 1);
+        for (int b = 0; b < k - 1; b++)
+            bound[b] = sample[(b + 1) * 64];
+        Ranges ranges(bound);
+        Evaluate("range", x, k, [&ranges](const Tuple& t) { return ranges.Find(t.key); });
+    }
+    return 0;
+}
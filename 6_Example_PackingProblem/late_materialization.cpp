@@ -0,0 +1,150 @@
+// Early against late materialization on a table of K int columns:
+//
+//     SELECT SUM(c0 + c1 + ... + c{K-1}) WHERE c0 < a AND c1 < 500
+//
+//   early     the doMAPFilter way: each filter copies every column of the
+//             matching rows (count per chunk, prefix, scatter), the next
+//             operator works on the copies
+//   indices   selection.h with an index list: the filters produce and shrink
+//             a list of row numbers, the sum gathers through it
+//   bitmap    selection.h with a bitmap: the second filter ANDs into it, the
+//             sum walks the set bits (full words as contiguous rows)
+//   adaptive  bitmap, converted to indices below kSelectionThreshold
+//
+// a sets the selectivity of the first predicate, the second keeps half of
+// the rows. Times in ms.
+//
+// g++ -O3 -march=native -std=c++17 late_materialization.cpp -pthread -ltbb
+// ./a.out [rows]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <random>
+
+#include <tbb/tbb.h>
+#include "oneapi/tbb/blocked_range.h"
+#include "oneapi/tbb/parallel_for.h"
+#include "oneapi/tbb/parallel_reduce.h"
+
+#include "selection.h"
+
+using namespace std;
+using namespace oneapi;
+
+typedef vector<vector<int>> Columns;
+
+// rows of cols where cols[c][i] < bound, all columns copied
+Columns Materialize(const Columns& cols, int c, int bound)
+{
+    const long B = 16384;
+    long n = cols[0].size(), blocks = (n + B - 1) / B;
+    const int* key = cols[c].data();
+    vector<long> offset(blocks + 1, 0);
+    tbb::parallel_for(
+        tbb::blocked_range<long>(0, blocks),
+        [&](tbb::blocked_range<long> r) {
+            for (long b = r.begin(); b < r.end(); b++) {
+                long cnt = 0;
+                for (long i = b * B; i < min(n, (b + 1) * B); i++)
+                    cnt += key[i] < bound;
+                offset[b + 1] = cnt;
+            }
+        }
+    );
+    for (long b = 0; b < blocks; b++)
+        offset[b + 1] += offset[b];
+    Columns out(cols.size(), vector<int>(offset[blocks]));
+    tbb::parallel_for(
+        tbb::blocked_range<long>(0, blocks),
+        [&](tbb::blocked_range<long> r) {
+            for (long b = r.begin(); b < r.end(); b++)
+                for (size_t k = 0; k < cols.size(); k++) {
+                    int* dst = out[k].data() + offset[b];
+                    for (long i = b * B; i < min(n, (b + 1) * B); i++)
+                        if (key[i] < bound)
+                            *dst++ = cols[k][i];
+                }
+        }
+    );
+    return out;
+}
+
+long RowSum(const Columns& cols, long i)
+{
+    long s = 0;
+    for (const vector<int>& c : cols)
+        s += c[i];
+    return s;
+}
+
+long Early(const Columns& cols, int a)
+{
+    Columns f1 = Materialize(cols, 0, a);
+    Columns f2 = Materialize(f1, 1, 500);
+    return tbb::parallel_reduce(
+        tbb::blocked_range<long>(0, f2[0].size()), 0L,
+        [&](tbb::blocked_range<long> r, long s) {
+            for (long i = r.begin(); i < r.end(); i++)
+                s += RowSum(f2, i);
+            return s;
+        },
+        plus<long>());
+}
+
+long Late(const Columns& cols, int a, double threshold, Selection::Kind& kind)
+{
+    long n = cols[0].size();
+    Selection s = Select(cols[0].data(), n, [a](int v) { return v < a; }, threshold);
+    Refine(s, cols[1].data(), [](int v) { return v < 500; }, threshold);
+    kind = s.kind;
+    return ReduceSelected(s, 0L, [&](long i) { return RowSum(cols, i); }, plus<long>());
+}
+
+template <class F>
+double Time(int reps, F f)
+{
+    f();
+    tbb::tick_count t0 = tbb::tick_count::now();
+    for (int r = 0; r < reps; r++)
+        f();
+    return (tbb::tick_count::now() - t0).seconds() / reps;
+}
+
+int main(int argc, char* argv[])
+{
+    long n = argc > 1 ? atol(argv[1]) : 4000000;
+    cout << "Default concurrency " << tbb::info::default_concurrency() << endl;
+    cout << "n = " << n << ", adaptive threshold " << kSelectionThreshold * 100 << "%" << endl;
+
+    for (int K : {2, 4, 16}) {
+        Columns cols(K, vector<int>(n));
+        tbb::parallel_for(tbb::blocked_range<int>(0, K), [&](tbb::blocked_range<int> r) {
+            for (int k = r.begin(); k < r.end(); k++) {
+                mt19937 gen(k);
+                uniform_int_distribution<int> u(0, 999);
+                for (auto& v : cols[k]) v = u(gen);
+            }
+        });
+
+        cout << endl << K << " columns" << endl;
+        cout << setw(12) << "selectivity" << setw(10) << "early" << setw(10) << "indices"
+             << setw(10) << "bitmap" << setw(12) << "adaptive" << endl;
+        for (int a : {1, 10, 20, 100, 500, 900, 1000}) {
+            long r0 = 0, r1 = 0, r2 = 0, r3 = 0;
+            Selection::Kind k1, k2, k3;
+            double t0 = Time(3, [&] { r0 = Early(cols, a); });
+            double t1 = Time(3, [&] { r1 = Late(cols, a, 1.1, k1); });
+            double t2 = Time(3, [&] { r2 = Late(cols, a, 0.0, k2); });
+            double t3 = Time(3, [&] { r3 = Late(cols, a, kSelectionThreshold, k3); });
+            bool ok = r0 == r1 && r0 == r2 && r0 == r3;
+            cout << setw(11) << fixed << setprecision(1) << a / 10.0 << "%" << setprecision(2)
+                 << setw(10) << t0 * 1e3 << setw(10) << t1 * 1e3 << setw(10) << t2 * 1e3
+                 << setw(9) << t3 * 1e3 << (k3 == Selection::Indices ? " ix" : " bm")
+                 << (ok ? "" : "   MISMATCH") << endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,68 @@
+// Filter as three parallel passes: MAP (match flags), SCAN (output
+// positions) and a scatter of the matching values.
+
+#ifndef MAP_SCAN_FILTER_H
+#define MAP_SCAN_FILTER_H
+
+#include <vector>
+
+#include <tbb/tbb.h>
+#include "oneapi/tbb/blocked_range.h"
+#include "oneapi/tbb/parallel_for.h"
+#include "oneapi/tbb/parallel_scan.h"
+
+inline std::vector<int> doMAP(int a,int x[], int n)
+{
+    std::vector<int> out(n);
+
+    oneapi::tbb::parallel_for(
+        oneapi::tbb::blocked_range<int>(0, n),
+
+        // lambda function
+        [&](oneapi::tbb::blocked_range<int> r) {
+            for (auto i = r.begin(); i != r.end(); i++) {
+                out[i] = x[i]>=a;
+            }
+        }
+
+    );
+    return out;
+}
+
+
+inline int doSCAN(int out[], const int in[],int n){
+    int total_sum = oneapi::tbb::parallel_scan(
+        oneapi::tbb::blocked_range<int>(0, n), //range
+        0, //id
+        [&](oneapi::tbb::blocked_range<int> r, int sum, bool is_final_scan){        
+            int tmp = sum;
+            for (int i = r.begin(); i < r.end(); ++i) {
+                tmp = tmp + in[i];
+                if (is_final_scan)
+                    out[i] = tmp;
+            }
+            return tmp;
+        },
+        [&]( int left, int right ) {
+            return left + right;
+        }
+    );
+    return total_sum;
+}
+
+//doMAPFilter(&out[0],&ix[0],&x[0],&filter_results[0], x.size())
+inline void doMAPFilter(int bolMatch[], int ixMatch[],int x[], int out[], int n){
+    oneapi::tbb::parallel_for(
+        oneapi::tbb::blocked_range<int>(0, n),
+        // lambda function
+        [&](oneapi::tbb::blocked_range<int> r) {
+            for (auto i = r.begin(); i < r.end(); i++) {
+                if (bolMatch[i]){
+                    out[ixMatch[i]-1] = x[i];    
+                }
+            }
+        }
+    );
+}
+
+#endif
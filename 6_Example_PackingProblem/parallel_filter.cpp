@@ -0,0 +1,183 @@
+// Checks and benchmarks parallel_filter.h against the serial <algorithm>
+// versions on records of 4, 16 and 64 bytes (an int key plus payload). The
+// predicate keeps keys below a threshold, so the selectivity can be chosen.
+//
+// Every result is compared with std::: copy_if, partition_copy, remove_if and
+// stable_partition must match element by element, partition must put exactly
+// the matching elements in front (same multiset, any order).
+//
+// g++ -O3 -march=native -std=c++17 parallel_filter.cpp -pthread -ltbb
+// ./a.out [n]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <string>
+
+#include <tbb/tbb.h>
+
+#include "parallel_filter.h"
+
+using namespace std;
+using namespace oneapi;
+
+template <int Bytes>
+struct Record {
+    int key;
+    int payload[Bytes / 4 - 1];
+
+    bool operator==(const Record& o) const {
+        return key == o.key && equal(payload, payload + Bytes / 4 - 1, o.payload);
+    }
+    bool operator<(const Record& o) const {
+        return key != o.key ? key < o.key : payload[0] < o.payload[0];
+    }
+};
+
+template <>
+struct Record<4> {
+    int key;
+    bool operator==(const Record& o) const { return key == o.key; }
+    bool operator<(const Record& o) const { return key < o.key; }
+};
+
+template <class F>
+double Time(int reps, F f)
+{
+    f();
+    tbb::tick_count t0 = tbb::tick_count::now();
+    for (int r = 0; r < reps; r++)
+        f();
+    return (tbb::tick_count::now() - t0).seconds() / reps;
+}
+
+int failures = 0;
+
+void Check(bool ok, const string& what)
+{
+    if (!ok) {
+        cout << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+void Row(const string& name, double t_std, double t_par)
+{
+    cout << "  " << left << setw(18) << name << right << fixed << setprecision(2)
+         << setw(10) << t_std * 1e3 << setw(10) << t_par * 1e3
+         << setw(9) << t_std / t_par << "x" << endl;
+}
+
+template <int Bytes>
+void Evaluate(long n, int percent)
+{
+    typedef Record<Bytes> R;
+    vector<R> x(n);
+    mt19937 gen(Bytes);
+    uniform_int_distribution<int> u(0, 99);
+    for (long i = 0; i < n; i++) {
+        R r;
+        r.key = u(gen);
+        if constexpr (Bytes > 4)
+            fill(r.payload, r.payload + Bytes / 4 - 1, (int)i);
+        x[i] = r;
+    }
+    int a = percent;
+    auto pred = [a](const R& r) { return r.key < a; };
+    string tag = to_string(Bytes) + "-byte records, " + to_string(percent) + "%";
+
+    cout << Bytes << "-byte records, n = " << n << ", " << percent << "% selected" << endl;
+    cout << "  " << left << setw(18) << "algorithm" << right << setw(10) << "std ms"
+         << setw(10) << "tbb ms" << setw(10) << "speedup" << endl;
+
+    vector<R> ref(n), out(n), ref_f(n), out_f(n);
+    typename vector<R>::iterator ref_end, out_end;
+
+    double ts = Time(3, [&] { ref_end = std::copy_if(x.begin(), x.end(), ref.begin(), pred); });
+    double tp = Time(3, [&] { out_end = parallel::copy_if(x.begin(), x.end(), out.begin(), pred); });
+    Check(ref_end - ref.begin() == out_end - out.begin() && equal(ref.begin(), ref_end, out.begin()),
+          "copy_if, " + tag);
+    Row("copy_if", ts, tp);
+
+    pair<typename vector<R>::iterator, typename vector<R>::iterator> rp, op;
+    ts = Time(3, [&] { rp = std::partition_copy(x.begin(), x.end(), ref.begin(), ref_f.begin(), pred); });
+    tp = Time(3, [&] { op = parallel::partition_copy(x.begin(), x.end(), out.begin(), out_f.begin(), pred); });
+    Check(rp.first - ref.begin() == op.first - out.begin() && equal(ref.begin(), rp.first, out.begin())
+          && rp.second - ref_f.begin() == op.second - out_f.begin() && equal(ref_f.begin(), rp.second, out_f.begin()),
+          "partition_copy, " + tag);
+    Row("partition_copy", ts, tp);
+
+    // the in-place algorithms get a fresh copy of x before every run
+    auto in_place = [&](const string& name, auto std_alg, auto par_alg, bool stable) {
+        double t_std = 0, t_par = 0;
+        for (int r = 0; r < 3; r++) {
+            ref = x;
+            tbb::tick_count t0 = tbb::tick_count::now();
+            ref_end = std_alg(ref.begin(), ref.end());
+            t_std += (tbb::tick_count::now() - t0).seconds();
+            out = x;
+            t0 = tbb::tick_count::now();
+            out_end = par_alg(out.begin(), out.end());
+            t_par += (tbb::tick_count::now() - t0).seconds();
+        }
+        bool ok = ref_end - ref.begin() == out_end - out.begin();
+        if (ok && stable) {
+            ok = equal(ref.begin(), ref_end, out.begin());
+            if (name != "remove_if")
+                ok = ok && equal(ref_end, ref.end(), out_end);
+        } else if (ok) {
+            ok = all_of(out.begin(), out_end, pred) && none_of(out_end, out.end(), pred);
+            sort(ref.begin(), ref.end());
+            sort(out.begin(), out.end());
+            ok = ok && ref == out;
+        }
+        Check(ok, name + ", " + tag);
+        Row(name, t_std, t_par);
+    };
+    in_place("remove_if",
+             [&](auto f, auto l) { return std::remove_if(f, l, pred); },
+             [&](auto f, auto l) { return parallel::remove_if(f, l, pred); }, true);
+    in_place("stable_partition",
+             [&](auto f, auto l) { return std::stable_partition(f, l, pred); },
+             [&](auto f, auto l) { return parallel::stable_partition(f, l, pred); }, true);
+    in_place("partition",
+             [&](auto f, auto l) { return std::partition(f, l, pred); },
+             [&](auto f, auto l) { return parallel::partition(f, l, pred); }, false);
+    cout << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    long n = argc > 1 ? atol(argv[1]) : 10000000;
+    cout << "Default concurrency " << tbb::info::default_concurrency() << endl << endl;
+
+    // the example of main.cpp, x[i] >= 10
+    vector<int> small{7, 1, 0, 13, 0, 15, 20, -1}, small_out(small.size());
+    auto end = parallel::copy_if(small.begin(), small.end(), small_out.begin(),
+                                 [](int v) { return v >= 10; });
+    cout << "Filtered vector: ";
+    for (auto it = small_out.begin(); it != end; ++it)
+        cout << *it << ',';
+    cout << endl << endl;
+
+    // edge cases: empty input, nothing and everything selected, sizes that
+    // are not a multiple of the chunk size
+    for (long m : {0L, 1L, 1023L, 1025L, 100000L})
+        for (int p : {0, 37, 100})
+            switch (m % 3) {
+            case 0: Evaluate<4>(m, p); break;
+            case 1: Evaluate<16>(m, p); break;
+            default: Evaluate<64>(m, p); break;
+            }
+    cout << "=====================================================" << endl << endl;
+
+    for (int p : {10, 50, 90}) {
+        Evaluate<4>(n, p);
+        Evaluate<16>(n, p);
+        Evaluate<64>(n / 4, p);
+    }
+    cout << (failures == 0 ? "all checks passed" : to_string(failures) + " checks FAILED") << endl;
+    return failures != 0;
+}
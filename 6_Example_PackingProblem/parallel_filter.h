@@ -0,0 +1,324 @@
+// Parallel counterparts of the <algorithm> filters, for any element type and
+// any predicate (doMAP/doSCAN/doMAPFilter only handle int and x[i] >= a):
+//
+//     auto end = parallel::copy_if(x.begin(), x.end(), out.begin(), pred);
+//     size_t kept = end - out.begin();
+//
+//   copy_if             stable, returns the end of the output
+//   partition_copy      stable, returns {end of true output, end of false output}
+//   remove_if           stable, in place, returns the new end
+//   stable_partition    in place, returns the partition point
+//   partition           in place, not stable, returns the partition point
+//   unique_copy         first element of every run of equal neighbours
+//   unique              the same in place, returns the new end
+//   unique_count        number of runs
+//   adjacent_difference out[i] = first[i] - first[i - 1], out[0] = first[0]
+//
+// All of them use the two-level scheme of fused_compaction.cpp: the input is
+// cut into chunks, one parallel pass counts the matches per chunk, the chunk
+// counts are scanned serially and a second parallel pass moves the elements.
+// The predicate is therefore called at least twice per element (three times
+// in partition) and must not have side effects. Iterators must be random
+// access, output iterators included.
+//
+// The unique family flags run heads by comparing every element with its
+// predecessor, across chunk edges too, and then compacts like copy_if.
+//
+// Extra memory: copy_if, partition_copy and unique_copy need O(chunks).
+// remove_if, unique and stable_partition stage the moved elements in a
+// temporary buffer (kept elements, or n for stable_partition). partition
+// swaps misplaced elements pairwise and only needs their indices, so it is
+// the cheapest when the order does not matter.
+
+#ifndef PARALLEL_FILTER_H
+#define PARALLEL_FILTER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include <oneapi/tbb/blocked_range.h>
+#include <oneapi/tbb/parallel_for.h>
+
+namespace parallel {
+
+namespace detail {
+
+// about 64 KB of elements per chunk, but at least 1024 elements
+template <class It>
+std::size_t ChunkSize()
+{
+    std::size_t bytes = sizeof(typename std::iterator_traits<It>::value_type);
+    return std::max<std::size_t>(1024, 65536 / bytes);
+}
+
+template <class Body>
+void ForEachChunk(std::size_t n, std::size_t chunk, Body body)
+{
+    oneapi::tbb::parallel_for(
+        oneapi::tbb::blocked_range<std::size_t>(0, (n + chunk - 1) / chunk),
+        [&](const oneapi::tbb::blocked_range<std::size_t>& r) {
+            for (std::size_t c = r.begin(); c != r.end(); ++c)
+                body(c, c * chunk, std::min(n, (c + 1) * chunk));
+        });
+}
+
+// offset[c] = number of indices i in chunks before c with flag(i),
+// offset[chunks] = total
+template <class Flag>
+std::vector<std::size_t> FlagOffsets(std::size_t n, std::size_t chunk, Flag& flag)
+{
+    std::vector<std::size_t> offset((n + chunk - 1) / chunk + 1, 0);
+    ForEachChunk(n, chunk, [&](std::size_t c, std::size_t lo, std::size_t hi) {
+        std::size_t cnt = 0;
+        for (std::size_t i = lo; i < hi; ++i)
+            cnt += flag(i) ? 1 : 0;
+        offset[c + 1] = cnt;
+    });
+    for (std::size_t c = 1; c < offset.size(); ++c)
+        offset[c] += offset[c - 1];
+    return offset;
+}
+
+template <class It, class Pred>
+std::vector<std::size_t> MatchOffsets(It first, std::size_t n, std::size_t chunk, Pred& pred)
+{
+    auto match = [&](std::size_t i) { return pred(first[i]); };
+    return FlagOffsets(n, chunk, match);
+}
+
+// first[i] starts a run of equal elements; i - 1 may lie in the previous chunk
+template <class It, class Eq>
+auto RunHead(It first, Eq& eq)
+{
+    return [first, &eq](std::size_t i) { return i == 0 || !eq(first[i - 1], first[i]); };
+}
+
+// matches of chunk c go to out_true + offset[c], the others to
+// out_false + (lo - offset[c]); Move chooses copy or move
+template <bool Move, class It, class OutTrue, class OutFalse, class Pred>
+void Scatter(It first, std::size_t n, std::size_t chunk, const std::vector<std::size_t>& offset,
+             OutTrue out_true, OutFalse out_false, Pred& pred)
+{
+    ForEachChunk(n, chunk, [&](std::size_t c, std::size_t lo, std::size_t hi) {
+        OutTrue t = out_true + offset[c];
+        OutFalse f = out_false + (lo - offset[c]);
+        for (std::size_t i = lo; i < hi; ++i) {
+            if (pred(first[i])) {
+                if constexpr (Move) *t++ = std::move(first[i]); else *t++ = first[i];
+            } else {
+                if constexpr (Move) *f++ = std::move(first[i]); else *f++ = first[i];
+            }
+        }
+    });
+}
+
+// drops the elements that would go to the false output
+struct Discard {
+    struct Sink { template <class T> Sink& operator=(T&&) { return *this; } };
+    Sink operator*() const { return Sink(); }
+    Discard& operator++() { return *this; }
+    Discard operator++(int) { return *this; }
+    Discard operator+(std::size_t) const { return *this; }
+};
+
+template <class It, class Out>
+void MoveRange(It first, std::size_t n, Out out)
+{
+    oneapi::tbb::parallel_for(
+        oneapi::tbb::blocked_range<std::size_t>(0, n),
+        [&](const oneapi::tbb::blocked_range<std::size_t>& r) {
+            for (std::size_t i = r.begin(); i != r.end(); ++i)
+                out[i] = std::move(first[i]);
+        });
+}
+
+} // namespace detail
+
+template <class It, class Out, class Pred>
+Out copy_if(It first, It last, Out out, Pred pred)
+{
+    std::size_t n = last - first, chunk = detail::ChunkSize<It>();
+    std::vector<std::size_t> offset = detail::MatchOffsets(first, n, chunk, pred);
+    detail::Scatter<false>(first, n, chunk, offset, out, detail::Discard(), pred);
+    return out + offset.back();
+}
+
+template <class It, class OutTrue, class OutFalse, class Pred>
+std::pair<OutTrue, OutFalse> partition_copy(It first, It last, OutTrue out_true,
+                                            OutFalse out_false, Pred pred)
+{
+    std::size_t n = last - first, chunk = detail::ChunkSize<It>();
+    std::vector<std::size_t> offset = detail::MatchOffsets(first, n, chunk, pred);
+    detail::Scatter<false>(first, n, chunk, offset, out_true, out_false, pred);
+    return {out_true + offset.back(), out_false + (n - offset.back())};
+}
+
+template <class It, class Pred>
+It remove_if(It first, It last, Pred pred)
+{
+    using T = typename std::iterator_traits<It>::value_type;
+    std::size_t n = last - first, chunk = detail::ChunkSize<It>();
+    auto keep = [&pred](const T& v) { return !pred(v); };
+    std::vector<std::size_t> offset = detail::MatchOffsets(first, n, chunk, keep);
+    // chunks cannot be compacted in place concurrently: the destination of a
+    // chunk can overlap the not yet read source of an earlier one
+    std::vector<T> kept(offset.back());
+    detail::Scatter<true>(first, n, chunk, offset, kept.begin(), detail::Discard(), keep);
+    detail::MoveRange(kept.begin(), kept.size(), first);
+    return first + kept.size();
+}
+
+template <class It, class Pred>
+It stable_partition(It first, It last, Pred pred)
+{
+    using T = typename std::iterator_traits<It>::value_type;
+    std::size_t n = last - first, chunk = detail::ChunkSize<It>();
+    std::vector<std::size_t> offset = detail::MatchOffsets(first, n, chunk, pred);
+    std::vector<T> tmp(n);
+    detail::Scatter<true>(first, n, chunk, offset, tmp.begin(), tmp.begin() + offset.back(), pred);
+    detail::MoveRange(tmp.begin(), n, first);
+    return first + offset.back();
+}
+
+template <class It, class Pred>
+It partition(It first, It last, Pred pred)
+{
+    std::size_t n = last - first, chunk = detail::ChunkSize<It>();
+    std::vector<std::size_t> offset = detail::MatchOffsets(first, n, chunk, pred);
+    std::size_t k = offset.back();
+
+    // the non-matching elements in [0, k) and the matching ones in [k, n)
+    // are misplaced; there are equally many of both, swap them pairwise
+    auto misplaced = [&](std::size_t i) { return (i < k) != (bool)pred(first[i]); };
+    std::vector<std::size_t> bad(offset.size(), 0);
+    detail::ForEachChunk(n, chunk, [&](std::size_t c, std::size_t lo, std::size_t hi) {
+        std::size_t cnt = 0;
+        for (std::size_t i = lo; i < hi; ++i)
+            cnt += misplaced(i) ? 1 : 0;
+        bad[c + 1] = cnt;
+    });
+    for (std::size_t c = 1; c < bad.size(); ++c)
+        bad[c] += bad[c - 1];
+
+    // left indices come first since chunks are in index order
+    std::vector<std::size_t> idx(bad.back());
+    detail::ForEachChunk(n, chunk, [&](std::size_t c, std::size_t lo, std::size_t hi) {
+        std::size_t j = bad[c];
+        for (std::size_t i = lo; i < hi; ++i)
+            if (misplaced(i))
+                idx[j++] = i;
+    });
+    std::size_t m = idx.size() / 2;
+    oneapi::tbb::parallel_for(
+        oneapi::tbb::blocked_range<std::size_t>(0, m),
+        [&](const oneapi::tbb::blocked_range<std::size_t>& r) {
+            using std::swap;
+            for (std::size_t i = r.begin(); i != r.end(); ++i)
+                swap(first[idx[i]], first[idx[m + i]]);
+        });
+    return first + k;
+}
+
+// Runs of equal elements, usually of sorted data. As in std::unique, eq is
+// applied to neighbours and the first element of every run is kept.
+
+template <class It, class Out, class Eq>
+Out unique_copy(It first, It last, Out out, Eq eq)
+{
+    std::size_t n = last - first, chunk = detail::ChunkSize<It>();
+    auto head = detail::RunHead(first, eq);
+    std::vector<std::size_t> offset = detail::FlagOffsets(n, chunk, head);
+    detail::ForEachChunk(n, chunk, [&](std::size_t c, std::size_t lo, std::size_t hi) {
+        Out o = out + offset[c];
+        for (std::size_t i = lo; i < hi; ++i)
+            if (head(i))
+                *o++ = first[i];
+    });
+    return out + offset.back();
+}
+
+template <class It, class Eq>
+It unique(It first, It last, Eq eq)
+{
+    using T = typename std::iterator_traits<It>::value_type;
+    std::size_t n = last - first, chunk = detail::ChunkSize<It>();
+    std::size_t chunks = (n + chunk - 1) / chunk;
+    auto head = detail::RunHead(first, eq);
+    std::vector<std::size_t> offset = detail::FlagOffsets(n, chunk, head);
+    // the flag of a chunk's first element compares with the previous chunk,
+    // which may already be moving its elements out: take it beforehand
+    std::vector<char> lead(chunks);
+    for (std::size_t c = 0; c < chunks; ++c)
+        lead[c] = head(c * chunk);
+
+    std::vector<T> kept(offset.back());
+    detail::ForEachChunk(n, chunk, [&](std::size_t c, std::size_t lo, std::size_t hi) {
+        // backwards, so that first[i] is compared before it is moved from
+        std::size_t o = offset[c + 1];
+        for (std::size_t i = hi - 1; i > lo; --i)
+            if (head(i))
+                kept[--o] = std::move(first[i]);
+        if (lead[c])
+            kept[--o] = std::move(first[lo]);
+    });
+    detail::MoveRange(kept.begin(), kept.size(), first);
+    return first + kept.size();
+}
+
+// number of runs, the size std::unique would leave
+template <class It, class Eq>
+std::size_t unique_count(It first, It last, Eq eq)
+{
+    auto head = detail::RunHead(first, eq);
+    return detail::FlagOffsets(last - first, detail::ChunkSize<It>(), head).back();
+}
+
+// out[0] = first[0], out[i] = op(first[i], first[i - 1]); unlike std, out
+// must not overlap the input
+template <class It, class Out, class Op>
+Out adjacent_difference(It first, It last, Out out, Op op)
+{
+    std::size_t n = last - first;
+    if (n == 0)
+        return out;
+    out[0] = first[0];
+    oneapi::tbb::parallel_for(
+        oneapi::tbb::blocked_range<std::size_t>(1, n, detail::ChunkSize<It>()),
+        [&](const oneapi::tbb::blocked_range<std::size_t>& r) {
+            for (std::size_t i = r.begin(); i != r.end(); ++i)
+                out[i] = op(first[i], first[i - 1]);
+        });
+    return out + n;
+}
+
+template <class It, class Out>
+Out unique_copy(It first, It last, Out out)
+{
+    return parallel::unique_copy(first, last, out, std::equal_to<>());
+}
+
+template <class It>
+It unique(It first, It last)
+{
+    return parallel::unique(first, last, std::equal_to<>());
+}
+
+template <class It>
+std::size_t unique_count(It first, It last)
+{
+    return parallel::unique_count(first, last, std::equal_to<>());
+}
+
+template <class It, class Out>
+Out adjacent_difference(It first, It last, Out out)
+{
+    return parallel::adjacent_difference(first, last, out, std::minus<>());
+}
+
+} // namespace parallel
+
+#endif
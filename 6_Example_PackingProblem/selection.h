@@ -0,0 +1,266 @@
+// Late materialization: a filter returns which rows match instead of copying
+// them, and later operators read the columns they need through it.
+//
+// A Selection over rows [0, n) is one of
+//
+//   Indices   sorted row numbers of the matches, 4 bytes per match
+//   Bitmap    one bit per row (doMAPBits of bitmask_compaction.cpp), n/8 bytes
+//
+// Indices are smaller and cheaper to walk when few rows match, the bitmap when
+// many do: at a selectivity s the index list costs 32 s bits per row against
+// one, and gathering through it loses the sequential access. Select() always
+// builds the bitmap first and converts it to indices when the selectivity is
+// below `threshold` (the conversion only reads the bitmap). Refine() applies
+// one more predicate of a conjunction and converts in the same way. Row
+// numbers are 32-bit, so selections over more than 2^32 rows stay bitmaps.
+//
+//     Selection s = Select(&price[0], n, [](float p) { return p > 100; });
+//     Refine(s, &qty[0], [](int q) { return q < 24; });
+//     double sum = ReduceSelected(s, 0.0, [&](long i) { return price[i]; }, plus<double>());
+
+#ifndef SELECTION_H
+#define SELECTION_H
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <oneapi/tbb/blocked_range.h>
+#include <oneapi/tbb/parallel_for.h>
+#include <oneapi/tbb/parallel_reduce.h>
+
+struct Selection {
+    enum Kind { Indices, Bitmap } kind = Bitmap;
+    long n = 0;                    // rows selected from
+    long count = 0;                // rows selected
+    std::vector<uint32_t> idx;     // Indices
+    std::vector<uint64_t> bits;    // Bitmap, bit i % 64 of word i / 64
+};
+
+const double kSelectionThreshold = 0.02;
+const long kBitmapBlock = 1024;   // words per block in ToIndices and Gather
+
+// whether the row numbers of [0, n) fit the 32-bit index list
+inline bool IndicesFit(long n) { return n - 1 <= (long)UINT32_MAX; }
+
+inline long CountBits(const std::vector<uint64_t>& bits)
+{
+    return oneapi::tbb::parallel_reduce(
+        oneapi::tbb::blocked_range<long>(0, bits.size()), 0L,
+        [&](const oneapi::tbb::blocked_range<long>& r, long c) {
+            for (long w = r.begin(); w < r.end(); w++)
+                c += __builtin_popcountll(bits[w]);
+            return c;
+        },
+        [](long a, long b) { return a + b; });
+}
+
+// offset[b] = set bits in the blocks of kBitmapBlock words before b
+inline std::vector<long> BlockOffsets(const std::vector<uint64_t>& bits)
+{
+    const long W = kBitmapBlock;
+    long words = bits.size(), blocks = (words + W - 1) / W;
+    std::vector<long> offset(blocks + 1, 0);
+    oneapi::tbb::parallel_for(
+        oneapi::tbb::blocked_range<long>(0, blocks),
+        [&](const oneapi::tbb::blocked_range<long>& r) {
+            for (long b = r.begin(); b < r.end(); b++) {
+                long c = 0;
+                for (long w = b * W; w < std::min(words, (b + 1) * W); w++)
+                    c += __builtin_popcountll(bits[w]);
+                offset[b + 1] = c;
+            }
+        });
+    for (long b = 0; b < blocks; b++)
+        offset[b + 1] += offset[b];
+    return offset;
+}
+
+// Bitmap -> Indices: popcount per block of words, prefix, then every block
+// walks its set bits
+inline void ToIndices(Selection& s)
+{
+    if (s.kind == Selection::Indices)
+        return;
+    if (!IndicesFit(s.n))
+        throw std::length_error("ToIndices: more than 2^32 rows");
+    const long W = kBitmapBlock;
+    std::vector<long> offset = BlockOffsets(s.bits);
+    long words = s.bits.size(), blocks = offset.size() - 1;
+    s.idx.resize(offset[blocks]);
+    oneapi::tbb::parallel_for(
+        oneapi::tbb::blocked_range<long>(0, blocks),
+        [&](const oneapi::tbb::blocked_range<long>& r) {
+            for (long b = r.begin(); b < r.end(); b++) {
+                uint32_t* dst = s.idx.data() + offset[b];
+                for (long w = b * W; w < std::min(words, (b + 1) * W); w++)
+                    for (uint64_t m = s.bits[w]; m; m &= m - 1)
+                        *dst++ = (uint32_t)(64 * w + __builtin_ctzll(m));
+            }
+        });
+    s.count = offset[blocks];
+    s.kind = Selection::Indices;
+    std::vector<uint64_t>().swap(s.bits);
+}
+
+template <class T, class Pred>
+Selection SelectBitmap(const T col[], long n, Pred pred)
+{
+    Selection s;
+    s.n = n;
+    s.bits.resize((n + 63) / 64);
+    oneapi::tbb::parallel_for(
+        oneapi::tbb::blocked_range<long>(0, s.bits.size()),
+        [&](const oneapi::tbb::blocked_range<long>& r) {
+            for (long w = r.begin(); w < r.end(); w++) {
+                const T* p = col + 64 * w;
+                long m = std::min(64L, n - 64 * w);
+                uint64_t b = 0;
+                for (long j = 0; j < m; j++)
+                    b |= (uint64_t)(bool)pred(p[j]) << j;
+                s.bits[w] = b;
+            }
+        });
+    s.count = CountBits(s.bits);
+    return s;
+}
+
+template <class T, class Pred>
+Selection Select(const T col[], long n, Pred pred, double threshold = kSelectionThreshold)
+{
+    Selection s = SelectBitmap(col, n, pred);
+    if (s.count < threshold * n && IndicesFit(n))
+        ToIndices(s);
+    return s;
+}
+
+// s = s AND pred(col[i]); pred is evaluated only for selected rows, except
+// that bitmap words with any bit set are evaluated whole (branch-free)
+template <class T, class Pred>
+void Refine(Selection& s, const T col[], Pred pred, double threshold = kSelectionThreshold)
+{
+    if (s.kind == Selection::Bitmap) {
+        long n = s.n;
+        oneapi::tbb::parallel_for(
+            oneapi::tbb::blocked_range<long>(0, s.bits.size()),
+            [&](const oneapi::tbb::blocked_range<long>& r) {
+                for (long w = r.begin(); w < r.end(); w++) {
+                    if (!s.bits[w])
+                        continue;
+                    const T* p = col + 64 * w;
+                    long m = std::min(64L, n - 64 * w);
+                    uint64_t b = 0;
+                    for (long j = 0; j < m; j++)
+                        b |= (uint64_t)(bool)pred(p[j]) << j;
+                    s.bits[w] &= b;
+                }
+            });
+        s.count = CountBits(s.bits);
+        if (s.count < threshold * n && IndicesFit(n))
+            ToIndices(s);
+        return;
+    }
+
+    // index list: two-level compaction into a new list
+    const long B = 16384;
+    long k = s.idx.size(), blocks = (k + B - 1) / B;
+    std::vector<long> offset(blocks + 1, 0);
+    oneapi::tbb::parallel_for(
+        oneapi::tbb::blocked_range<long>(0, blocks),
+        [&](const oneapi::tbb::blocked_range<long>& r) {
+            for (long b = r.begin(); b < r.end(); b++) {
+                long c = 0;
+                for (long j = b * B; j < std::min(k, (b + 1) * B); j++)
+                    c += (bool)pred(col[s.idx[j]]);
+                offset[b + 1] = c;
+            }
+        });
+    for (long b = 0; b < blocks; b++)
+        offset[b + 1] += offset[b];
+    std::vector<uint32_t> out(offset[blocks]);
+    oneapi::tbb::parallel_for(
+        oneapi::tbb::blocked_range<long>(0, blocks),
+        [&](const oneapi::tbb::blocked_range<long>& r) {
+            for (long b = r.begin(); b < r.end(); b++) {
+                uint32_t* dst = out.data() + offset[b];
+                for (long j = b * B; j < std::min(k, (b + 1) * B); j++)
+                    if (pred(col[s.idx[j]]))
+                        *dst++ = s.idx[j];
+            }
+        });
+    s.idx.swap(out);
+    s.count = s.idx.size();
+}
+
+// op over f(i) for the selected rows i, in parallel
+template <class V, class F, class Op>
+V ReduceSelected(const Selection& s, V identity, F f, Op op)
+{
+    if (s.kind == Selection::Indices) {
+        return oneapi::tbb::parallel_reduce(
+            oneapi::tbb::blocked_range<long>(0, s.idx.size()), identity,
+            [&](const oneapi::tbb::blocked_range<long>& r, V acc) {
+                for (long j = r.begin(); j < r.end(); j++)
+                    acc = op(acc, f((long)s.idx[j]));
+                return acc;
+            },
+            op);
+    }
+    return oneapi::tbb::parallel_reduce(
+        oneapi::tbb::blocked_range<long>(0, s.bits.size()), identity,
+        [&](const oneapi::tbb::blocked_range<long>& r, V acc) {
+            for (long w = r.begin(); w < r.end(); w++) {
+                uint64_t m = s.bits[w];
+                if (m == ~0ULL) {
+                    // full word: contiguous rows, the loop vectorizes
+                    for (long i = 64 * w; i < 64 * w + 64; i++)
+                        acc = op(acc, f(i));
+                } else {
+                    for (; m; m &= m - 1)
+                        acc = op(acc, f(64 * w + __builtin_ctzll(m)));
+                }
+            }
+            return acc;
+        },
+        op);
+}
+
+// materializes col over the selection: out[j] = col[j-th selected row]
+template <class T>
+void Gather(const Selection& s, const T col[], T out[])
+{
+    if (s.kind == Selection::Indices) {
+        oneapi::tbb::parallel_for(
+            oneapi::tbb::blocked_range<long>(0, s.idx.size()),
+            [&](const oneapi::tbb::blocked_range<long>& r) {
+                for (long j = r.begin(); j < r.end(); j++)
+                    out[j] = col[s.idx[j]];
+            });
+        return;
+    }
+    // straight from the words: blocks write from their popcount offsets, full
+    // words copy 64 contiguous rows
+    const long W = kBitmapBlock;
+    std::vector<long> offset = BlockOffsets(s.bits);
+    long words = s.bits.size(), blocks = offset.size() - 1;
+    oneapi::tbb::parallel_for(
+        oneapi::tbb::blocked_range<long>(0, blocks),
+        [&](const oneapi::tbb::blocked_range<long>& r) {
+            for (long b = r.begin(); b < r.end(); b++) {
+                T* dst = out + offset[b];
+                for (long w = b * W; w < std::min(words, (b + 1) * W); w++) {
+                    uint64_t m = s.bits[w];
+                    if (m == ~0ULL) {
+                        std::copy(col + 64 * w, col + 64 * w + 64, dst);
+                        dst += 64;
+                    } else {
+                        for (; m; m &= m - 1)
+                            *dst++ = col[64 * w + __builtin_ctzll(m)];
+                    }
+                }
+            }
+        });
+}
+
+#endif
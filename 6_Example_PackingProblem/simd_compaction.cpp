@@ -0,0 +1,240 @@
+// SIMD compress-store bodies for doMAPFilter-style filtering (keep x >= a).
+//
+// A branch per element is mispredicted about half of the time when the
+// matches are random and the selectivity is near 50%. Compress-store kernels
+// compare a whole vector, turn the result into a bit mask and pack the
+// matching lanes to the front of the vector with one permutation:
+//
+//   avx512   vpcompressd into a register, then a masked store of popcount(mask)
+//            lanes (the memory form of vpcompressd is microcoded on some cores)
+//   avx2     vpermd with the lane order taken from a 256-entry table indexed by
+//            the 8-bit compare mask, then a full 8-lane store; the lanes past
+//            popcount(mask) are garbage and are overwritten by the next store
+//   scalar   branch-free: always store, advance the output by (x >= a)
+//   branchy  if (x >= a) store, the baseline
+//
+// The kernel is chosen at run time with __builtin_cpu_supports, every SIMD
+// kernel is compiled with a target attribute, so the file builds without
+// -march and runs on any x86-64.
+//
+// The parallel driver is the two-level scheme of fused_compaction.cpp: count
+// per chunk, scan the counts, compress every chunk straight to its output
+// offset. Full-width stores of the avx2 kernel may not write past the end of
+// their chunk's output (the next chunk owns it), so a kernel gets `room`, the
+// number of output slots it owns, and finishes with scalar code near the end.
+//
+// g++ -O3 -std=c++17 simd_compaction.cpp -pthread -ltbb
+// ./a.out [n]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <cstdint>
+#include <immintrin.h>
+
+#include <tbb/tbb.h>
+#include "oneapi/tbb/blocked_range.h"
+#include "oneapi/tbb/parallel_for.h"
+
+using namespace std;
+using namespace oneapi;
+
+// writes the elements of in[0, n) that are >= a to out[0, room) and returns
+// how many; room must be at least the number of matches
+typedef long (*CompressFn)(const int* in, long n, int a, int* out, long room);
+
+long CompressBranchy(const int* in, long n, int a, int* out, long)
+{
+    long k = 0;
+    for (long i = 0; i < n; i++)
+        if (in[i] >= a)
+            out[k++] = in[i];
+    return k;
+}
+
+long CompressScalar(const int* in, long n, int a, int* out, long room)
+{
+    long k = 0, i = 0;
+    // the unconditional store needs one free slot
+    for (; i < n && k < room; i++) {
+        out[k] = in[i];
+        k += in[i] >= a;
+    }
+    return k;
+}
+
+// lane indices for every 8-bit mask, packed as bytes
+struct PermTable {
+    uint64_t idx[256];
+    PermTable() {
+        for (int m = 0; m < 256; m++) {
+            uint64_t v = 0;
+            int k = 0;
+            for (int j = 0; j < 8; j++)
+                if (m & (1 << j))
+                    v |= (uint64_t)j << (8 * k++);
+            idx[m] = v;
+        }
+    }
+};
+static const PermTable perm;
+
+__attribute__((target("avx2,popcnt")))
+long CompressAvx2(const int* in, long n, int a, int* out, long room)
+{
+    __m256i va = _mm256_set1_epi32(a);
+    long k = 0, i = 0;
+    for (; i + 8 <= n && k + 8 <= room; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(in + i));
+        __m256i lt = _mm256_cmpgt_epi32(va, v);
+        unsigned m = ~_mm256_movemask_ps(_mm256_castsi256_ps(lt)) & 0xff;
+        __m256i p = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(perm.idx[m]));
+        _mm256_storeu_si256((__m256i*)(out + k), _mm256_permutevar8x32_epi32(v, p));
+        k += _mm_popcnt_u32(m);
+    }
+    return k + CompressBranchy(in + i, n - i, a, out + k, room - k);
+}
+
+__attribute__((target("avx512f,popcnt")))
+long CompressAvx512(const int* in, long n, int a, int* out, long)
+{
+    __m512i va = _mm512_set1_epi32(a);
+    long k = 0, i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_loadu_si512(in + i);
+        __mmask16 m = _mm512_cmpge_epi32_mask(v, va);
+        _mm512_mask_storeu_epi32(out + k, (__mmask16)((1u << _mm_popcnt_u32(m)) - 1),
+                                 _mm512_maskz_compress_epi32(m, v));
+        k += _mm_popcnt_u32(m);
+    }
+    if (i < n) {
+        __mmask16 tail = (__mmask16)((1u << (n - i)) - 1);
+        __m512i v = _mm512_maskz_loadu_epi32(tail, in + i);
+        __mmask16 m = _mm512_mask_cmpge_epi32_mask(tail, v, va);
+        _mm512_mask_compressstoreu_epi32(out + k, m, v);
+        k += _mm_popcnt_u32(m);
+    }
+    return k;
+}
+
+struct Kernel {
+    string name;
+    CompressFn fn;
+    bool supported;
+};
+
+vector<Kernel> Kernels()
+{
+    __builtin_cpu_init();
+    return {{"avx512", CompressAvx512, (bool)__builtin_cpu_supports("avx512f")},
+            {"avx2", CompressAvx2, (bool)__builtin_cpu_supports("avx2")},
+            {"scalar", CompressScalar, true},
+            {"branchy", CompressBranchy, true}};
+}
+
+// the best kernel this CPU runs
+CompressFn SelectCompress()
+{
+    for (const Kernel& k : Kernels())
+        if (k.supported)
+            return k.fn;
+    return CompressScalar;
+}
+
+// ---------------------------------------------------------------------------
+
+const long CHUNK = 16384;
+
+long Filter(const int x[], long n, int a, int out[], CompressFn compress)
+{
+    long chunks = (n + CHUNK - 1) / CHUNK;
+    vector<long> offset(chunks + 1, 0);
+    tbb::parallel_for(
+        tbb::blocked_range<long>(0, chunks),
+        [&](tbb::blocked_range<long> r) {
+            for (long c = r.begin(); c < r.end(); c++) {
+                long cnt = 0;
+                for (long i = c * CHUNK; i < min(n, (c + 1) * CHUNK); i++)
+                    cnt += x[i] >= a;
+                offset[c + 1] = cnt;
+            }
+        }
+    );
+    for (long c = 0; c < chunks; c++)
+        offset[c + 1] += offset[c];
+    tbb::parallel_for(
+        tbb::blocked_range<long>(0, chunks),
+        [&](tbb::blocked_range<long> r) {
+            for (long c = r.begin(); c < r.end(); c++) {
+                long lo = c * CHUNK, hi = min(n, lo + CHUNK);
+                compress(x + lo, hi - lo, a, out + offset[c], offset[c + 1] - offset[c]);
+            }
+        }
+    );
+    return offset[chunks];
+}
+
+template <class F>
+double Time(int reps, F f)
+{
+    f();
+    tbb::tick_count t0 = tbb::tick_count::now();
+    for (int r = 0; r < reps; r++)
+        f();
+    return (tbb::tick_count::now() - t0).seconds() / reps;
+}
+
+int main(int argc, char* argv[])
+{
+    long n = argc > 1 ? atol(argv[1]) : 20000000;
+    cout << "Default concurrency " << tbb::info::default_concurrency() << endl;
+
+    vector<Kernel> kernels = Kernels();
+    cout << "Kernels:";
+    for (const Kernel& k : kernels)
+        cout << ' ' << k.name << (k.supported ? "" : " (not supported)");
+    cout << endl;
+
+    // the example of main.cpp
+    vector<int> small{7, 1, 0, 13, 0, 15, 20, -1}, small_out(small.size());
+    long m = Filter(&small[0], small.size(), 10, &small_out[0], SelectCompress());
+    cout << "Filtered vector: ";
+    for (long i = 0; i < m; i++)
+        cout << small_out[i] << ',';
+    cout << endl << endl;
+
+    // keys 0..999 in random order, keep x >= a for a = 1000 * (1 - selectivity)
+    vector<int> x(n);
+    mt19937 gen(3);
+    uniform_int_distribution<int> u(0, 999);
+    for (auto& v : x) v = u(gen);
+
+    cout << "n = " << n << ", filter throughput in 10^9 elements/s" << endl;
+    cout << setw(12) << "selectivity";
+    for (const Kernel& k : kernels)
+        if (k.supported)
+            cout << setw(10) << k.name;
+    cout << endl;
+
+    vector<int> ref(n), out(n);
+    for (int percent = 0; percent <= 100; percent += 10) {
+        int a = 1000 - 10 * percent;
+        long mref = CompressBranchy(&x[0], n, a, &ref[0], n);
+        cout << setw(11) << percent << "%";
+        for (const Kernel& k : kernels) {
+            if (!k.supported)
+                continue;
+            fill(out.begin(), out.end(), -1);
+            long mk = 0;
+            double t = Time(3, [&] { mk = Filter(&x[0], n, a, &out[0], k.fn); });
+            bool ok = mk == mref && equal(ref.begin(), ref.begin() + mref, out.begin());
+            cout << setw(10) << fixed << setprecision(2) << n / t * 1e-9 << (ok ? "" : "!");
+        }
+        cout << endl;
+    }
+    cout << "(! = output differs from the serial filter)" << endl;
+    return 0;
+}
@@ -0,0 +1,270 @@
+// Streaming filter: out = x[i] for every x[i] >= a, for inputs that do not
+// fit in memory. The input is a file or pipe of raw ints, processed as a
+// tbb::parallel_pipeline of three stages:
+//
+//   read     serial in order   fills the next free chunk of CHUNK ints
+//   filter   parallel          compacts the chunk with the steps of main.cpp
+//                              done per block: count, prefix, scatter, each
+//                              a parallel_for over the blocks of the chunk
+//   write    serial in order   appends the chunk to the output, so the output
+//                              offset of a chunk is the total kept before it
+//
+// At most Tokens() chunks are in flight and they come from a fixed pool of at
+// most BUFFER_BYTES, so memory use does not grow with the input size or with
+// the core count; parallelism beyond the token count comes from the
+// parallel_for inside every chunk.
+//
+// A failed read or write stops the pipeline and is reported, as are trailing
+// bytes of the input that do not form a whole int; the exit status is then 1.
+//
+// Without arguments a test file of n ints is written to /tmp, filtered and
+// checked against a serial pass; otherwise "-" stands for stdin / stdout:
+//
+// g++ -O3 -march=native -std=c++17 streaming_filter.cpp -pthread -ltbb
+// ./a.out [n]
+// ./a.out <input|-> <output|-> [a]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+
+#include <tbb/tbb.h>
+#include "oneapi/tbb/blocked_range.h"
+#include "oneapi/tbb/parallel_for.h"
+#include "oneapi/tbb/parallel_pipeline.h"
+#include "oneapi/tbb/concurrent_queue.h"
+
+using namespace std;
+using namespace oneapi;
+
+const long CHUNK = 1 << 22;            // ints per pipeline item (16 MB)
+const long BLOCK = 16384;              // ints per block inside a chunk
+const long BUFFER_BYTES = 256L << 20;  // input and output buffers of all chunks
+
+struct Chunk {
+    vector<int> in, out;
+    long n = 0;          // ints read
+    long kept = 0;       // ints that passed
+    Chunk() : in(CHUNK), out(CHUNK) {}
+};
+
+// compacts c.in[0, c.n) into c.out, returns the number kept
+long FilterChunk(Chunk& c, int a)
+{
+    long blocks = (c.n + BLOCK - 1) / BLOCK;
+    vector<long> offset(blocks + 1, 0);
+    const int* x = c.in.data();
+    tbb::parallel_for(
+        tbb::blocked_range<long>(0, blocks),
+        [&](tbb::blocked_range<long> r) {
+            for (long b = r.begin(); b < r.end(); b++) {
+                long cnt = 0, hi = min(c.n, (b + 1) * BLOCK);
+                for (long i = b * BLOCK; i < hi; i++)
+                    cnt += x[i] >= a;
+                offset[b + 1] = cnt;
+            }
+        }
+    );
+    for (long b = 0; b < blocks; b++)
+        offset[b + 1] += offset[b];
+    tbb::parallel_for(
+        tbb::blocked_range<long>(0, blocks),
+        [&](tbb::blocked_range<long> r) {
+            for (long b = r.begin(); b < r.end(); b++) {
+                int* dst = c.out.data() + offset[b];
+                long hi = min(c.n, (b + 1) * BLOCK);
+                for (long i = b * BLOCK; i < hi; i++)
+                    if (x[i] >= a)
+                        *dst++ = x[i];
+            }
+        }
+    );
+    return offset[blocks];
+}
+
+int Tokens()
+{
+    long budget = BUFFER_BYTES / (2 * CHUNK * sizeof(int));
+    return (int)max(2L, min(budget, 2L * tbb::info::default_concurrency()));
+}
+
+struct Stats {
+    long in = 0, out = 0, chunks = 0;
+    double seconds = 0;
+    string error;        // empty if all input was read and written
+};
+
+Stats StreamFilter(FILE* in, FILE* out, int a)
+{
+    int tokens = Tokens();
+    vector<Chunk> pool(tokens);
+    tbb::concurrent_queue<Chunk*> free_chunks;
+    for (Chunk& c : pool)
+        free_chunks.push(&c);
+
+    Stats s;
+    long total = 0;
+    atomic<bool> failed(false);   // set by the write stage, read by the read stage
+    tbb::tick_count t0 = tbb::tick_count::now();
+    tbb::parallel_pipeline(
+        tokens,
+        tbb::make_filter<void, Chunk*>(
+            tbb::filter_mode::serial_in_order,
+            [&](tbb::flow_control& fc) -> Chunk* {
+                Chunk* c = nullptr;
+                free_chunks.try_pop(c);   // never empty: one chunk per token
+                // bytes, so a partial int at the end is seen; fread only
+                // returns short at the end of the input or on an error
+                size_t bytes = failed ? 0 : fread(c->in.data(), 1, CHUNK * sizeof(int), in);
+                c->n = bytes / sizeof(int);
+                if (bytes < CHUNK * sizeof(int) && s.error.empty()) {
+                    if (ferror(in))
+                        s.error = "read error";
+                    else if (bytes % sizeof(int))
+                        s.error = to_string(bytes % sizeof(int)) + " trailing bytes do not form an int";
+                }
+                if (c->n == 0) {
+                    free_chunks.push(c);
+                    fc.stop();
+                    return nullptr;
+                }
+                return c;
+            }) &
+        tbb::make_filter<Chunk*, Chunk*>(
+            tbb::filter_mode::parallel,
+            [a](Chunk* c) {
+                c->kept = FilterChunk(*c, a);
+                return c;
+            }) &
+        tbb::make_filter<Chunk*, void>(
+            tbb::filter_mode::serial_in_order,
+            [&](Chunk* c) {
+                if (!failed && (long)fwrite(c->out.data(), sizeof(int), c->kept, out) < c->kept)
+                    failed = true;
+                if (!failed) {
+                    total += c->kept;
+                    s.in += c->n;
+                    s.chunks++;
+                }
+                free_chunks.push(c);
+            })
+    );
+    if (fflush(out) != 0)
+        failed = true;
+    if (failed)
+        s.error = "write error after " + to_string(total) + " ints";
+    s.out = total;
+    s.seconds = (tbb::tick_count::now() - t0).seconds();
+    return s;
+}
+
+void Report(const Stats& s, int a)
+{
+    double mem = Tokens() * CHUNK * 2.0 * sizeof(int);
+    cerr << "a = " << a << ": " << s.in << " ints in, " << s.out << " out, "
+         << s.chunks << " chunks" << endl;
+    cerr << fixed << setprecision(2) << s.seconds << " s, "
+         << s.in * sizeof(int) / s.seconds * 1e-9 << " GB/s in, "
+         << s.out * sizeof(int) / s.seconds * 1e-9 << " GB/s out, buffers "
+         << mem / (1 << 20) << " MB" << endl;
+    if (!s.error.empty())
+        cerr << "ERROR: " << s.error << endl;
+}
+
+// ---------------------------------------------------------------------------
+
+// reads both files a chunk at a time and compares out with a serial filter of in
+bool Check(const string& in_name, const string& out_name, int a)
+{
+    FILE* in = fopen(in_name.c_str(), "rb");
+    FILE* out = fopen(out_name.c_str(), "rb");
+    vector<int> x(CHUNK), y(CHUNK);
+    long have = 0, pos = 0;   // ints of out in y, next one to compare
+    bool ok = in && out;
+    long n;
+    while (ok && (n = fread(x.data(), sizeof(int), CHUNK, in)) > 0)
+        for (long i = 0; ok && i < n; i++) {
+            if (x[i] < a)
+                continue;
+            if (pos == have) {
+                have = fread(y.data(), sizeof(int), CHUNK, out);
+                pos = 0;
+            }
+            ok = pos < have && y[pos++] == x[i];
+        }
+    ok = ok && pos == have && fread(y.data(), sizeof(int), 1, out) == 0;
+    if (in) fclose(in);
+    if (out) fclose(out);
+    return ok;
+}
+
+int SelfTest(long n)
+{
+    string in_name = "/tmp/streaming_filter_in.bin", out_name = "/tmp/streaming_filter_out.bin";
+    cerr << "Default concurrency " << tbb::info::default_concurrency() << endl;
+    cerr << "writing " << n << " ints to " << in_name << endl;
+    FILE* f = fopen(in_name.c_str(), "wb");
+    if (!f) {
+        cerr << "cannot write " << in_name << endl;
+        return 1;
+    }
+    mt19937 gen(5);
+    uniform_int_distribution<int> v(0, 999);
+    vector<int> x(CHUNK);
+    bool written = true;
+    for (long done = 0; written && done < n; done += CHUNK) {
+        long m = min(CHUNK, n - done);
+        for (long i = 0; i < m; i++)
+            x[i] = v(gen);
+        written = (long)fwrite(x.data(), sizeof(int), m, f) == m;
+    }
+    if (fclose(f) != 0 || !written) {
+        cerr << "cannot write " << in_name << endl;
+        remove(in_name.c_str());
+        return 1;
+    }
+
+    bool ok = true;
+    for (int a : {0, 500, 990}) {
+        FILE* in = fopen(in_name.c_str(), "rb");
+        FILE* out = fopen(out_name.c_str(), "wb");
+        Stats s = StreamFilter(in, out, a);
+        fclose(in);
+        if (fclose(out) != 0 && s.error.empty())
+            s.error = "cannot close " + out_name;
+        Report(s, a);
+        if (!s.error.empty() || !Check(in_name, out_name, a)) {
+            cerr << "MISMATCH" << endl;
+            ok = false;
+        }
+    }
+    remove(in_name.c_str());
+    remove(out_name.c_str());
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+        return SelfTest(argc > 1 ? atol(argv[1]) : 1L << 28);
+
+    string in_name = argv[1], out_name = argv[2];
+    int a = argc > 3 ? atoi(argv[3]) : 10;
+    FILE* in = in_name == "-" ? stdin : fopen(in_name.c_str(), "rb");
+    FILE* out = out_name == "-" ? stdout : fopen(out_name.c_str(), "wb");
+    if (!in || !out) {
+        cerr << "cannot open " << (in ? out_name : in_name) << endl;
+        return 1;
+    }
+    Stats s = StreamFilter(in, out, a);
+    if (out != stdout && fclose(out) != 0 && s.error.empty())
+        s.error = "cannot close " + out_name;
+    Report(s, a);
+    return s.error.empty() ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+// Checks and benchmarks the unique family of parallel_filter.h against
+// std::unique and std::adjacent_difference on sorted columns:
+//
+//   int64     sorted 64-bit keys with n, n / 2, n / 16, n / 1000 and 1 distinct values
+//   records   {key, payload} sorted by key, equal when the keys are (custom eq)
+//   strings   sorted short strings over a 4-letter alphabet
+//
+// The std::unique and parallel::unique columns work in place (on a fresh
+// copy each time), unique_copy writes to a second array, unique_count only
+// counts. Every result is compared with the serial one.
+//
+// g++ -O3 -march=native -std=c++17 unique.cpp -pthread -ltbb
+// ./a.out [n]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+#include <cstdint>
+
+#include <tbb/tbb.h>
+
+#include "parallel_filter.h"
+
+using namespace std;
+using namespace oneapi;
+
+struct Record {
+    int64_t key;
+    int64_t payload;
+    bool operator==(const Record& o) const { return key == o.key && payload == o.payload; }
+};
+
+// f compacts its argument in place and returns the new size
+template <class T, class F>
+double TimeInPlace(const vector<T>& data, vector<T>& work, int reps, size_t& kept, F f)
+{
+    double t = 0;
+    for (int r = 0; r < reps; r++) {
+        work = data;
+        tbb::tick_count t0 = tbb::tick_count::now();
+        kept = f(work);
+        t += (tbb::tick_count::now() - t0).seconds();
+    }
+    work.resize(kept);
+    return t / reps;
+}
+
+template <class F>
+double Time(int reps, F f)
+{
+    f();
+    tbb::tick_count t0 = tbb::tick_count::now();
+    for (int r = 0; r < reps; r++)
+        f();
+    return (tbb::tick_count::now() - t0).seconds() / reps;
+}
+
+template <class T, class Eq>
+void Evaluate(const string& name, const vector<T>& x, Eq eq)
+{
+    size_t n = x.size(), k_std = 0, k_par = 0, k_copy = 0, k_count = 0;
+    vector<T> ref, out, copied(n);
+    double t_std = TimeInPlace(x, ref, 3, k_std, [&](vector<T>& v) -> size_t {
+        return unique(v.begin(), v.end(), eq) - v.begin();
+    });
+    double t_par = TimeInPlace(x, out, 3, k_par, [&](vector<T>& v) -> size_t {
+        return parallel::unique(v.begin(), v.end(), eq) - v.begin();
+    });
+    double t_copy = Time(3, [&] {
+        k_copy = parallel::unique_copy(x.begin(), x.end(), copied.begin(), eq) - copied.begin();
+    });
+    double t_count = Time(3, [&] { k_count = parallel::unique_count(x.begin(), x.end(), eq); });
+    copied.resize(k_copy);
+
+    bool ok = out == ref && copied == ref && k_count == k_std;
+    cout << setw(22) << name << setw(11) << k_std << fixed << setprecision(1)
+         << setw(10) << n / t_std * 1e-6 << setw(10) << n / t_par * 1e-6
+         << setw(12) << n / t_copy * 1e-6 << setw(10) << n / t_count * 1e-6
+         << setw(9) << setprecision(2) << t_std / t_par << "x" << (ok ? "" : "   MISMATCH") << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    long n = argc > 1 ? atol(argv[1]) : 50000000;
+    if (n <= 0) {
+        cerr << "n must be positive" << endl;
+        return 1;
+    }
+    cout << "Default concurrency " << tbb::info::default_concurrency() << endl;
+
+    // the example of main.cpp, sorted
+    vector<int> small{7, 1, 0, 13, 0, 15, 20, -1, 7, 13}, small_out(small.size());
+    sort(small.begin(), small.end());
+    small.erase(parallel::unique(small.begin(), small.end()), small.end());
+    parallel::adjacent_difference(small.begin(), small.end(), small_out.begin());
+    cout << "Unique: ";
+    for (int v : small) cout << v << ',';
+    cout << endl << "Gaps: ";
+    for (size_t i = 0; i < small.size(); i++) cout << small_out[i] << ',';
+    cout << endl << endl;
+
+    cout << "n = " << n << ", 10^6 elements/s" << endl;
+    cout << setw(22) << "input" << setw(11) << "runs" << setw(10) << "std" << setw(10) << "unique"
+         << setw(12) << "unique_copy" << setw(10) << "count" << setw(10) << "vs std" << endl;
+
+    mt19937_64 gen(21);
+    vector<int64_t> keys(n);
+    auto same = [](int64_t a, int64_t b) { return a == b; };
+    // at least one distinct value, so small n still runs every case
+    for (long distinct : {n, max(1L, n / 2), max(1L, n / 16), max(1L, n / 1000), 1L}) {
+        for (auto& k : keys) k = (int64_t)(gen() % distinct);
+        tbb::parallel_sort(keys.begin(), keys.end());
+        Evaluate("int64 " + to_string(distinct) + " distinct", keys, same);
+    }
+
+    vector<Record> recs(n / 2);
+    for (auto& r : recs) r = Record{(int64_t)(gen() % max(1L, n / 8)), (int64_t)gen()};
+    tbb::parallel_sort(recs.begin(), recs.end(), [](const Record& a, const Record& b) {
+        return a.key < b.key;
+    });
+    Evaluate("records by key", recs, [](const Record& a, const Record& b) { return a.key == b.key; });
+
+    vector<string> words(n / 8);
+    uniform_int_distribution<int> len(1, 8), ch('a', 'd');
+    for (auto& w : words) {
+        w.resize(len(gen));
+        for (auto& c : w) c = (char)ch(gen);
+    }
+    tbb::parallel_sort(words.begin(), words.end());
+    Evaluate("strings", words, [](const string& a, const string& b) { return a == b; });
+
+    // adjacent_difference on the sorted key column (gaps, as in delta coding)
+    for (auto& k : keys) k = (int64_t)(gen() % n);
+    tbb::parallel_sort(keys.begin(), keys.end());
+    vector<int64_t> d_std(n), d_par(n);
+    double t_std = Time(3, [&] { adjacent_difference(keys.begin(), keys.end(), d_std.begin()); });
+    double t_par = Time(3, [&] { parallel::adjacent_difference(keys.begin(), keys.end(), d_par.begin()); });
+    cout << endl << "adjacent_difference: std " << fixed << setprecision(1) << n / t_std * 1e-6
+         << ", parallel " << n / t_par * 1e-6 << setprecision(2) << " (" << t_std / t_par << "x)"
+         << (d_std == d_par ? "" : "   MISMATCH") << endl;
+    return 0;
+}
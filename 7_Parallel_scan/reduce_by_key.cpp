@@ -0,0 +1,204 @@
+// Parallel reduce_by_key and segmented reduction with tbb::parallel_scan.
+//
+// Input arrives as runs of equal keys, e.g. (customer, amount) sorted by
+// customer. The scan state carries
+//     segs - number of segment heads seen so far
+//     tail - op-sum of the values since the last head
+// and two states combine as
+//     (l, r) -> { l.segs + r.segs,  r.segs ? r.tail : op(l.tail, r.tail) }
+// which is associative, so a segment that crosses any chunk boundary is
+// stitched together by the scan itself. In the final pass the element that
+// ends a segment writes the total to slot segs-1: the output is compacted
+// in the same sweep, no second pass is needed.
+//
+// g++ -O3 -march=native -std=c++17 reduce_by_key.cpp -pthread -ltbb
+// ./a.out [n]
+
+#include <oneapi/tbb/info.h>
+#include <oneapi/tbb/parallel_for.h>
+#include <oneapi/tbb/parallel_scan.h>
+#include <oneapi/tbb/tick_count.h>
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace oneapi;
+
+template <class V>
+struct SegState {
+    long segs;
+    V tail;
+};
+
+// Core: is_head(i) tells whether element i starts a segment, value(i) gives
+// its value and emit(ordinal, i, total) is called once per segment, at the
+// segment's last element. Returns the number of segments.
+template <class V, class Op, class Head, class Value, class Emit>
+long SegmentedScan(long n, V identity, Op op, Head is_head, Value value, Emit emit)
+{
+    if (n == 0)
+        return 0;
+    SegState<V> total = tbb::parallel_scan(
+        tbb::blocked_range<long>(0, n),
+        SegState<V>{0, identity},
+        [&](const tbb::blocked_range<long>& r, SegState<V> s, bool is_final_scan) {
+            for (long i = r.begin(); i < r.end(); i++) {
+                if (is_head(i)) {
+                    s.segs++;
+                    s.tail = value(i);
+                } else {
+                    s.tail = op(s.tail, value(i));
+                }
+                if (is_final_scan && (i == n - 1 || is_head(i + 1)))
+                    emit(s.segs - 1, i, s.tail);
+            }
+            return s;
+        },
+        [&](const SegState<V>& l, const SegState<V>& r) {
+            return SegState<V>{l.segs + r.segs, r.segs ? r.tail : op(l.tail, r.tail)};
+        }
+    );
+    return total.segs;
+}
+
+// Collapses every run of equal keys into one (key, op-sum) pair.
+// out_keys/out_vals must have room for n entries; returns the number written.
+template <class K, class V, class Op = std::plus<V>, class Eq = std::equal_to<K>>
+long ReduceByKey(const K keys[], const V vals[], long n, K out_keys[], V out_vals[],
+                 V identity = V(), Op op = Op(), Eq eq = Eq())
+{
+    return SegmentedScan<V>(n, identity, op,
+        [&](long i) { return i == 0 || !eq(keys[i], keys[i - 1]); },
+        [&](long i) { return vals[i]; },
+        [&](long seg, long i, const V& v) {
+            out_keys[seg] = keys[i];
+            out_vals[seg] = v;
+        });
+}
+
+// Segment s is vals[offsets[s], offsets[s+1]); empty segments get identity.
+template <class V, class Op = std::plus<V>>
+void SegmentedReduce(const V vals[], const long offsets[], long nsegs, V out[],
+                     V identity = V(), Op op = Op())
+{
+    long n = offsets[nsegs];
+    std::vector<char> head(n, 0);
+    tbb::parallel_for(tbb::blocked_range<long>(0, nsegs),
+        [&](const tbb::blocked_range<long>& r) {
+            for (long s = r.begin(); s < r.end(); s++) {
+                out[s] = identity;
+                if (offsets[s] < offsets[s + 1])
+                    head[offsets[s]] = 1;
+            }
+        });
+
+    SegmentedScan<V>(n, identity, op,
+        [&](long i) { return head[i] != 0; },
+        [&](long i) { return vals[i]; },
+        [&](long, long i, const V& v) {
+            long s = std::upper_bound(offsets, offsets + nsegs + 1, i) - offsets - 1;
+            out[s] = v;
+        });
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark
+// ---------------------------------------------------------------------------
+
+template <class K, class V>
+long SerialReduceByKey(const K keys[], const V vals[], long n, K out_keys[], V out_vals[])
+{
+    long m = 0;
+    for (long i = 0; i < n; i++) {
+        if (i == 0 || keys[i] != keys[i - 1]) {
+            out_keys[m] = keys[i];
+            out_vals[m++] = vals[i];
+        } else {
+            out_vals[m - 1] += vals[i];
+        }
+    }
+    return m;
+}
+
+// Sorted keys whose run lengths come from next_len().
+template <class F>
+std::vector<int> MakeKeys(long n, F next_len)
+{
+    std::vector<int> keys(n);
+    long i = 0;
+    int k = 0;
+    while (i < n) {
+        long len = std::max(1L, next_len());
+        for (long j = 0; j < len && i < n; j++)
+            keys[i++] = k;
+        k++;
+    }
+    return keys;
+}
+
+void Benchmark(const std::string& name, const std::vector<int>& keys)
+{
+    long n = keys.size();
+    std::vector<long> vals(n), ref_v(n), out_v(n);
+    std::vector<int> ref_k(n), out_k(n);
+    for (long i = 0; i < n; i++)
+        vals[i] = (i * 7919) % 1000;
+
+    tbb::tick_count t0 = tbb::tick_count::now();
+    long m_ref = SerialReduceByKey(&keys[0], &vals[0], n, &ref_k[0], &ref_v[0]);
+    double ts = (tbb::tick_count::now() - t0).seconds();
+
+    t0 = tbb::tick_count::now();
+    long m = ReduceByKey(&keys[0], &vals[0], n, &out_k[0], &out_v[0]);
+    double tp = (tbb::tick_count::now() - t0).seconds();
+
+    bool ok = m == m_ref && std::equal(ref_k.begin(), ref_k.begin() + m, out_k.begin())
+                         && std::equal(ref_v.begin(), ref_v.begin() + m, out_v.begin());
+
+    std::cout << std::left << std::setw(22) << name << std::right
+              << std::setw(11) << m << std::fixed << std::setprecision(1)
+              << std::setw(12) << n / ts * 1e-6 << std::setw(12) << n / tp * 1e-6
+              << (ok ? "   ok" : "   MISMATCH") << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    long n = argc > 1 ? atol(argv[1]) : 20000000;
+    std::cout << "Default concurrency " << oneapi::tbb::info::default_concurrency() << std::endl;
+
+    // small example: per-customer sums
+    std::vector<int> customer = {3, 3, 5, 7, 7, 7, 9};
+    std::vector<double> amount = {1.5, 2.0, 10.0, 1.0, 1.0, 1.0, 4.25};
+    std::vector<int> ck(customer.size());
+    std::vector<double> cv(customer.size());
+    long m = ReduceByKey(&customer[0], &amount[0], customer.size(), &ck[0], &cv[0]);
+    for (long i = 0; i < m; i++)
+        std::cout << "customer " << ck[i] << ": " << cv[i] << std::endl;
+
+    // segmented max over explicit offsets, including an empty segment
+    std::vector<long> offsets = {0, 3, 3, 7};
+    std::vector<int> sv = {4, 9, 2, 1, 8, 3, 5}, smax(3);
+    SegmentedReduce(&sv[0], &offsets[0], 3, &smax[0], -1,
+                    [](int a, int b) { return std::max(a, b); });
+    std::cout << "segment max: " << smax[0] << ' ' << smax[1] << ' ' << smax[2] << std::endl;
+
+    std::cout << std::endl << "n = " << n << ", throughput in M elements/s" << std::endl;
+    std::cout << std::left << std::setw(22) << "segment lengths" << std::right
+              << std::setw(11) << "segments" << std::setw(12) << "serial"
+              << std::setw(12) << "parallel" << std::endl;
+
+    std::mt19937 gen(11);
+    Benchmark("all 1", MakeKeys(n, [] { return 1L; }));
+    Benchmark("constant 8", MakeKeys(n, [] { return 8L; }));
+    Benchmark("constant 1000", MakeKeys(n, [] { return 1000L; }));
+    std::geometric_distribution<long> geo(1.0 / 32);
+    Benchmark("geometric mean 32", MakeKeys(n, [&] { return geo(gen); }));
+    std::lognormal_distribution<double> heavy(2.0, 2.5);
+    Benchmark("lognormal heavy tail", MakeKeys(n, [&] { return (long)heavy(gen); }));
+    Benchmark("one huge segment", MakeKeys(n, [n] { return n; }));
+    return 0;
+}
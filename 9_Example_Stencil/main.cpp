@@ -0,0 +1,276 @@
+// Jacobi heat diffusion on structured 1D/2D/3D grids.
+//
+// Stencils: 3-point (1D), 5-point (2D), 7-point and 27-point (3D).
+// All grids are stored with a one-cell halo of fixed (Dirichlet) boundary
+// values and two buffers that are swapped after every timestep.
+//
+// Two schedules over tbb::blocked_range3d (1D and 2D grids are 3D grids with
+// one cell and no halo in the unused dimensions):
+//
+//   tiled     - one parallel_for per timestep, the simple_partitioner hands out
+//               cache-sized tiles
+//   temporal  - overlapped temporal blocking: every tile copies its region plus
+//               a T-cell apron into a thread-local scratch, runs T timesteps
+//               there (the valid region shrinks by one cell per step) and writes
+//               the core back. T timesteps cost one pass over memory, paid for
+//               with some redundant work on the aprons. Tiles are independent,
+//               so unlike wavefront/diamond schedules no inter-tile
+//               synchronisation is needed inside a parallel_for.
+//
+// Both schedules perform the same arithmetic, so their results are identical.
+// Performance is reported in GLUPS (10^9 lattice-site updates per second).
+//
+// g++ -O3 -march=native -std=c++17 main.cpp -pthread -ltbb
+// ./a.out [timesteps] [T]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <cmath>
+
+#include <tbb/tbb.h>
+#include "oneapi/tbb/blocked_range3d.h"
+#include "oneapi/tbb/parallel_for.h"
+#include "oneapi/tbb/task_arena.h"
+#include "oneapi/tbb/enumerable_thread_specific.h"
+
+using namespace std;
+using namespace oneapi;
+
+struct Grid {
+    int n[3];      // interior cells per dimension (x, y, z)
+    int h[3];      // halo width per dimension (0 or 1)
+    int N[3];      // allocated cells per dimension
+    long sy, sz;   // strides
+    vector<double> a, b;
+
+    Grid(int nx, int ny, int nz) {
+        int d[3] = {nx, ny, nz};
+        for (int k = 0; k < 3; k++) {
+            n[k] = d[k];
+            h[k] = d[k] > 1 ? 1 : 0;
+            N[k] = n[k] + 2 * h[k];
+        }
+        sy = N[0];
+        sz = (long)N[0] * N[1];
+        a.assign((long)N[0] * N[1] * N[2], 0.0);
+    }
+    long points() const { return (long)n[0] * n[1] * n[2]; }
+    long idx(int x, int y, int z) const { return x + y * sy + z * sz; }
+};
+
+// ---------------------------------------------------------------------------
+// Stencils: new value of cell i of `in`, sy/sz are the y/z strides
+// ---------------------------------------------------------------------------
+
+struct Heat3 {
+    static const char* name() { return "1D 3-point"; }
+    double operator()(const double* in, long i, long, long) const {
+        return in[i] + 0.25 * (in[i - 1] + in[i + 1] - 2.0 * in[i]);
+    }
+};
+
+struct Heat5 {
+    static const char* name() { return "2D 5-point"; }
+    double operator()(const double* in, long i, long sy, long) const {
+        return in[i] + 0.2 * (in[i - 1] + in[i + 1] + in[i - sy] + in[i + sy] - 4.0 * in[i]);
+    }
+};
+
+struct Heat7 {
+    static const char* name() { return "3D 7-point"; }
+    double operator()(const double* in, long i, long sy, long sz) const {
+        return in[i] + 0.1 * (in[i - 1] + in[i + 1] + in[i - sy] + in[i + sy]
+                              + in[i - sz] + in[i + sz] - 6.0 * in[i]);
+    }
+};
+
+struct Heat27 {
+    static const char* name() { return "3D 27-point"; }
+    double operator()(const double* in, long i, long sy, long sz) const {
+        const double w0 = 0.4, w1 = 0.06, w2 = 0.015, w3 = 0.0075; // sums to 1
+        double faces = 0, edges = 0, corners = 0;
+        for (int dz = -1; dz <= 1; dz++)
+            for (int dy = -1; dy <= 1; dy++) {
+                const double* p = in + i + dz * sz + dy * sy;
+                int k = (dz != 0) + (dy != 0);
+                double row = p[-1] + p[1];
+                if (k == 0) { faces += row; }
+                else if (k == 1) { faces += p[0]; edges += row; }
+                else { edges += p[0]; corners += row; }
+            }
+        return w0 * in[i] + w1 * faces + w2 * edges + w3 * corners;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Schedules
+// ---------------------------------------------------------------------------
+
+struct Tile { int x, y, z; };
+
+tbb::blocked_range3d<int> InteriorRange(const Grid& g, Tile t)
+{
+    return tbb::blocked_range3d<int>(g.h[2], g.h[2] + g.n[2], t.z,
+                                     g.h[1], g.h[1] + g.n[1], t.y,
+                                     g.h[0], g.h[0] + g.n[0], t.x);
+}
+
+template <class Stencil>
+void RunTiled(Grid& g, int steps, Tile tile, Stencil st)
+{
+    for (int s = 0; s < steps; s++) {
+        const double* in = &g.a[0];
+        double* out = &g.b[0];
+        tbb::parallel_for(InteriorRange(g, tile),
+            [&](const tbb::blocked_range3d<int>& r) {
+                for (int z = r.pages().begin(); z < r.pages().end(); z++)
+                    for (int y = r.rows().begin(); y < r.rows().end(); y++) {
+                        long i = g.idx(0, y, z);
+                        for (int x = r.cols().begin(); x < r.cols().end(); x++)
+                            out[i + x] = st(in, i + x, g.sy, g.sz);
+                    }
+            },
+            tbb::simple_partitioner());
+        g.a.swap(g.b);
+    }
+}
+
+struct Scratch {
+    vector<double> a, b;
+};
+
+template <class Stencil>
+void RunTemporal(Grid& g, int steps, int T, Tile tile, Stencil st)
+{
+    tbb::enumerable_thread_specific<Scratch> scratch;
+
+    for (int done = 0; done < steps; done += T) {
+        int tb = min(T, steps - done);
+        const double* in = &g.a[0];
+        double* out = &g.b[0];
+
+        tbb::parallel_for(InteriorRange(g, tile),
+            [&](const tbb::blocked_range3d<int>& r) {
+                int lo[3] = {r.cols().begin(), r.rows().begin(), r.pages().begin()};
+                int hi[3] = {r.cols().end(), r.rows().end(), r.pages().end()};
+                int elo[3], ehi[3], E[3];
+                for (int k = 0; k < 3; k++) {
+                    elo[k] = max(0, lo[k] - tb * g.h[k]);
+                    ehi[k] = min(g.N[k], hi[k] + tb * g.h[k]);
+                    E[k] = ehi[k] - elo[k];
+                }
+                long sy = E[0], sz = (long)E[0] * E[1];
+                Scratch& sc = scratch.local();
+                sc.a.resize(sz * E[2]);
+                sc.b.resize(sz * E[2]);
+
+                for (int z = 0; z < E[2]; z++)
+                    for (int y = 0; y < E[1]; y++) {
+                        const double* src = in + g.idx(elo[0], elo[1] + y, elo[2] + z);
+                        copy(src, src + E[0], &sc.a[z * sz + y * sy]);
+                        copy(src, src + E[0], &sc.b[z * sz + y * sy]);
+                    }
+
+                for (int s = 1; s <= tb; s++) {
+                    // cells still needed after this step, clipped to the interior
+                    int clo[3], chi[3];
+                    for (int k = 0; k < 3; k++) {
+                        clo[k] = max(g.h[k], lo[k] - (tb - s) * g.h[k]) - elo[k];
+                        chi[k] = min(g.h[k] + g.n[k], hi[k] + (tb - s) * g.h[k]) - elo[k];
+                    }
+                    const double* cur = &sc.a[0];
+                    double* next = &sc.b[0];
+                    for (int z = clo[2]; z < chi[2]; z++)
+                        for (int y = clo[1]; y < chi[1]; y++) {
+                            long i = z * sz + y * sy;
+                            for (int x = clo[0]; x < chi[0]; x++)
+                                next[i + x] = st(cur, i + x, sy, sz);
+                        }
+                    sc.a.swap(sc.b);
+                }
+
+                for (int z = lo[2]; z < hi[2]; z++)
+                    for (int y = lo[1]; y < hi[1]; y++) {
+                        const double* src = &sc.a[(z - elo[2]) * sz + (y - elo[1]) * sy + lo[0] - elo[0]];
+                        copy(src, src + (hi[0] - lo[0]), out + g.idx(lo[0], y, z));
+                    }
+            },
+            tbb::simple_partitioner());
+        g.a.swap(g.b);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark
+// ---------------------------------------------------------------------------
+
+// hot boundary on the x = 0 face, cold everywhere else
+void Init(Grid& g)
+{
+    fill(g.a.begin(), g.a.end(), 0.0);
+    for (int z = 0; z < g.N[2]; z++)
+        for (int y = 0; y < g.N[1]; y++)
+            g.a[g.idx(0, y, z)] = 100.0;
+    for (long i = 0; i < (long)g.a.size(); i++)
+        g.a[i] += 1e-3 * (i % 97);
+    g.b = g.a;
+}
+
+template <class Stencil>
+void Benchmark(int nx, int ny, int nz, Tile tile, int steps, int T, int threads, Stencil st)
+{
+    Grid g(nx, ny, nz);
+    tbb::task_arena arena(threads);
+    double t1 = 0, t2 = 0;
+    vector<double> ref;
+
+    arena.execute([&] {
+        Init(g);
+        tbb::tick_count t0 = tbb::tick_count::now();
+        RunTiled(g, steps, tile, st);
+        t1 = (tbb::tick_count::now() - t0).seconds();
+        ref = g.a;
+
+        Init(g);
+        t0 = tbb::tick_count::now();
+        RunTemporal(g, steps, T, tile, st);
+        t2 = (tbb::tick_count::now() - t0).seconds();
+    });
+
+    double lups = (double)g.points() * steps;
+    string size = to_string(nx) + (ny > 1 ? "x" + to_string(ny) : "") + (nz > 1 ? "x" + to_string(nz) : "");
+    cout << setw(12) << Stencil::name() << setw(16) << size << setw(8) << threads
+         << fixed << setprecision(3) << setw(10) << lups / t1 * 1e-9 << setw(12) << lups / t2 * 1e-9
+         << (ref == g.a ? "" : "   MISMATCH") << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    int steps = argc > 1 ? atoi(argv[1]) : 16;
+    int T = argc > 2 ? atoi(argv[2]) : 4;
+    int max_threads = tbb::info::default_concurrency();
+    cout << "Default concurrency " << max_threads << endl;
+    cout << steps << " timesteps, temporal block T = " << T << ", GLUPS" << endl;
+    cout << setw(12) << "stencil" << setw(16) << "grid" << setw(8) << "threads"
+         << setw(10) << "tiled" << setw(12) << "temporal" << endl;
+
+    vector<int> threads;
+    for (int p = 1; p < max_threads; p *= 2)
+        threads.push_back(p);
+    threads.push_back(max_threads);
+
+    for (int p : threads) {
+        for (int n : {1 << 16, 1 << 20, 1 << 24})
+            Benchmark(n, 1, 1, Tile{4096, 1, 1}, steps, T, p, Heat3());
+        for (int n : {256, 1024, 4096})
+            Benchmark(n, n, 1, Tile{512, 32, 1}, steps, T, p, Heat5());
+        for (int n : {32, 128, 256}) {
+            Benchmark(n, n, n, Tile{128, 16, 16}, steps, T, p, Heat7());
+            Benchmark(n, n, n, Tile{128, 16, 16}, steps, T, p, Heat27());
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,290 @@
+// Parallel histogram engine.
+//
+// The word count in main.cpp pays one hash-map lock per element even when the
+// key space is tiny. For numeric bins there are cheaper options:
+//
+//   Private  - every thread owns a full bin array (enumerable_thread_specific),
+//              arrays are added together with a parallel tree merge.
+//              Best while bins * threads stays cache sized.
+//   Atomic   - one shared array of atomic counters. No merge cost and no
+//              extra memory, contention is low when bins >> threads.
+//   Sort     - compute bin ids, tbb::parallel_sort them and count run lengths.
+//              The counting work depends only on n; the bin count costs just
+//              one zero-filled output array, written at one slot per distinct
+//              id. Useful when bins are huge and the input is small relative
+//              to the bin array.
+//
+// Auto picks between them from the bin count, thread count and input size.
+// Binning rules: uniform width, log scale and custom (sorted) edges.
+//
+// g++ -O3 -march=native -std=c++17 histogram.cpp -pthread -ltbb
+// ./a.out [n]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <cmath>
+#include <string>
+
+#include <tbb/tbb.h>
+#include "oneapi/tbb/blocked_range.h"
+#include "oneapi/tbb/parallel_for.h"
+#include "oneapi/tbb/parallel_sort.h"
+#include "oneapi/tbb/enumerable_thread_specific.h"
+
+using namespace oneapi::tbb;
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// Binning rules: map a value to [0, bins) or -1 when out of range
+// ---------------------------------------------------------------------------
+
+struct UniformBins {
+    double lo, hi;
+    long bins;
+    double scale;
+    UniformBins(double lo_, double hi_, long bins_)
+        : lo(lo_), hi(hi_), bins(bins_), scale(bins_ / (hi_ - lo_)) {}
+    long operator()(double v) const {
+        if (!(v >= lo && v < hi))
+            return -1;
+        return min(bins - 1, (long)((v - lo) * scale));
+    }
+};
+
+struct LogBins {
+    UniformBins u;
+    LogBins(double lo, double hi, long bins) : u(log(lo), log(hi), bins) {}
+    long bins_count() const { return u.bins; }
+    long operator()(double v) const { return v > 0 ? u(log(v)) : -1; }
+};
+
+// bin b covers [edges[b], edges[b+1])
+struct EdgeBins {
+    vector<double> edges;
+    explicit EdgeBins(vector<double> e) : edges(move(e)) {}
+    long operator()(double v) const {
+        if (!(v >= edges.front() && v < edges.back()))
+            return -1;
+        return upper_bound(edges.begin(), edges.end(), v) - edges.begin() - 1;
+    }
+};
+
+long BinCount(const UniformBins& b) { return b.bins; }
+long BinCount(const LogBins& b) { return b.bins_count(); }
+long BinCount(const EdgeBins& b) { return b.edges.size() - 1; }
+
+// ---------------------------------------------------------------------------
+// Strategies
+// ---------------------------------------------------------------------------
+
+enum class Strategy { Auto, Private, Atomic, Sort };
+
+string Name(Strategy s)
+{
+    switch (s) {
+        case Strategy::Private: return "private";
+        case Strategy::Atomic:  return "atomic";
+        case Strategy::Sort:    return "sort";
+        default:                return "auto";
+    }
+}
+
+template <class Bins>
+vector<long> HistPrivate(const double x[], long n, const Bins& rule)
+{
+    long bins = BinCount(rule);
+    enumerable_thread_specific<vector<long>> local([bins] { return vector<long>(bins, 0); });
+
+    parallel_for(
+        blocked_range<long>(0, n),
+        [&](blocked_range<long> r) {
+            vector<long>& h = local.local();
+            for (long i = r.begin(); i < r.end(); i++) {
+                long b = rule(x[i]);
+                if (b >= 0)
+                    h[b]++;
+            }
+        }
+    );
+
+    // tree merge: pairs of private arrays are added in parallel, log2(T) rounds
+    vector<vector<long>*> parts;
+    for (auto& h : local)
+        parts.push_back(&h);
+    if (parts.empty())
+        return vector<long>(bins, 0);
+    for (size_t stride = 1; stride < parts.size(); stride *= 2) {
+        parallel_for(
+            blocked_range<size_t>(0, (parts.size() + 2 * stride - 1) / (2 * stride), 1),
+            [&](blocked_range<size_t> r) {
+                for (size_t p = r.begin(); p < r.end(); p++) {
+                    size_t a = 2 * stride * p, b = a + stride;
+                    if (b >= parts.size())
+                        continue;
+                    long* dst = parts[a]->data();
+                    const long* src = parts[b]->data();
+                    parallel_for(blocked_range<long>(0, bins, 4096),
+                        [&](blocked_range<long> q) {
+                            for (long i = q.begin(); i < q.end(); i++)
+                                dst[i] += src[i];
+                        });
+                }
+            }
+        );
+    }
+    return move(*parts[0]);
+}
+
+template <class Bins>
+vector<long> HistAtomic(const double x[], long n, const Bins& rule)
+{
+    long bins = BinCount(rule);
+    vector<atomic<long>> shared(bins);
+    parallel_for(blocked_range<long>(0, bins),
+        [&](blocked_range<long> r) {
+            for (long i = r.begin(); i < r.end(); i++)
+                shared[i].store(0, memory_order_relaxed);
+        });
+
+    parallel_for(
+        blocked_range<long>(0, n),
+        [&](blocked_range<long> r) {
+            for (long i = r.begin(); i < r.end(); i++) {
+                long b = rule(x[i]);
+                if (b >= 0)
+                    shared[b].fetch_add(1, memory_order_relaxed);
+            }
+        }
+    );
+
+    vector<long> out(bins);
+    parallel_for(blocked_range<long>(0, bins),
+        [&](blocked_range<long> r) {
+            for (long i = r.begin(); i < r.end(); i++)
+                out[i] = shared[i].load(memory_order_relaxed);
+        });
+    return out;
+}
+
+template <class Bins>
+vector<long> HistSort(const double x[], long n, const Bins& rule)
+{
+    long bins = BinCount(rule);
+    vector<long> ids(n);
+    parallel_for(blocked_range<long>(0, n),
+        [&](blocked_range<long> r) {
+            for (long i = r.begin(); i < r.end(); i++)
+                ids[i] = rule(x[i]);
+        });
+    parallel_sort(ids.begin(), ids.end());
+
+    // every run of equal ids is counted by the chunk that holds its first element
+    vector<long> out(bins, 0);
+    parallel_for(
+        blocked_range<long>(0, n),
+        [&](blocked_range<long> r) {
+            long i = r.begin();
+            while (i > 0 && i < r.end() && ids[i] == ids[i - 1])
+                i++;
+            while (i < r.end()) {
+                long j = i + 1;
+                while (j < n && ids[j] == ids[i])
+                    j++;
+                if (ids[i] >= 0)
+                    out[ids[i]] = j - i;
+                i = j;
+            }
+        }
+    );
+    return out;
+}
+
+// Private bins win while the per-thread copies (and their merge) stay small;
+// past that, atomics avoid the T*bins memory; sort still allocates the bins
+// output once, but when that array dwarfs the input its sequential fill is
+// cheaper than n random cache misses into it.
+Strategy Choose(long bins, long n, int threads)
+{
+    const long private_budget = 1L << 21; // total counters across threads (~16 MB)
+    if (bins > 64 * n)
+        return Strategy::Sort;
+    if (bins * threads <= private_budget || threads == 1)
+        return Strategy::Private;
+    return Strategy::Atomic;
+}
+
+template <class Bins>
+vector<long> Histogram(const double x[], long n, const Bins& rule, Strategy s = Strategy::Auto)
+{
+    if (s == Strategy::Auto)
+        s = Choose(BinCount(rule), n, this_task_arena::max_concurrency());
+    switch (s) {
+        case Strategy::Private: return HistPrivate(x, n, rule);
+        case Strategy::Atomic:  return HistAtomic(x, n, rule);
+        default:                return HistSort(x, n, rule);
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+template <class Bins>
+vector<long> HistSerial(const double x[], long n, const Bins& rule)
+{
+    vector<long> h(BinCount(rule), 0);
+    for (long i = 0; i < n; i++) {
+        long b = rule(x[i]);
+        if (b >= 0)
+            h[b]++;
+    }
+    return h;
+}
+
+template <class Bins>
+void Run(const string& label, const vector<double>& x, const Bins& rule)
+{
+    long n = x.size(), bins = BinCount(rule);
+    vector<long> ref = HistSerial(&x[0], n, rule);
+    Strategy pick = Choose(bins, n, this_task_arena::max_concurrency());
+
+    cout << setw(10) << label << setw(10) << bins;
+    for (Strategy s : {Strategy::Private, Strategy::Atomic, Strategy::Sort}) {
+        tick_count t0 = tick_count::now();
+        vector<long> h = Histogram(&x[0], n, rule, s);
+        double t = (tick_count::now() - t0).seconds();
+        cout << setw(9) << fixed << setprecision(2) << t * 1e3 << (h == ref ? "  " : " !");
+    }
+    cout << setw(9) << Name(pick) << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    long n = argc > 1 ? atol(argv[1]) : 10000000;
+    cout << "Default concurrency " << info::default_concurrency() << endl;
+
+    vector<double> x(n);
+    parallel_for(blocked_range<long>(0, n),
+        [&](blocked_range<long> r) {
+            mt19937 gen(r.begin());
+            lognormal_distribution<double> d(0.0, 1.0);
+            for (long i = r.begin(); i < r.end(); i++)
+                x[i] = d(gen);
+        });
+
+    cout << "n = " << n << " lognormal(0,1) samples, times in ms ('!' = mismatch)" << endl;
+    cout << setw(10) << "rule" << setw(10) << "bins" << setw(11) << "private"
+         << setw(11) << "atomic" << setw(11) << "sort" << setw(9) << "auto" << endl;
+
+    for (long bins = 16; bins <= 10000000; bins *= 8)
+        Run("uniform", x, UniformBins(0.0, 20.0, bins));
+    Run("uniform", x, UniformBins(0.0, 20.0, 10000000));
+    for (long bins : {16L, 4096L, 1000000L})
+        Run("log", x, LogBins(1e-3, 1e3, bins));
+
+    vector<double> edges{0.0, 0.1, 0.25, 0.5, 1.0, 2.0, 4.0, 8.0, 1e9};
+    Run("edges", x, EdgeBins(edges));
+    return 0;
+}